@@ -0,0 +1,443 @@
+// hft_bench: throughput and scaling benchmarks for hft_sim.
+//
+// Builds the engine straight from hft_sim.cpp (its main() is compiled out)
+// and runs four one-dimensional sweeps around a baseline run:
+//   ticks        1e5 .. 1e8 ticks
+//   instruments  10 .. 100k instruments
+//   capacity     PriceHistory depth (compile-time, one engine per value)
+//   signals      which built-in strategies are enabled (+ the SIMD lane path)
+// Every case is run `warmup` + `repeats` times. Each repetition times feed
+// generation, processing, reporting (into a null stream) and CSV export
+// separately. Each case runs in a forked child so its RSS is its own.
+// Min/median/mean per phase, ticks/s, ns/tick and RSS go to
+// stdout and to a JSON file, so two builds can be compared run for run.
+#define HFT_SIM_NO_MAIN
+#include "hft_sim.cpp"
+
+#include <cstdlib>
+#include <ctime>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#endif
+
+// Same strategies over a deeper history. S2/S4 average over the whole
+// history, so capacity changes both the footprint and the signal windows.
+template<size_t CAP, class P>
+struct WithCapacity : P {
+    static_assert(CAP >= P::window, "history shallower than the strategies need");
+    using History = PriceHistory<CAP>;
+};
+
+using SignalsS1 = SignalPipeline<ThresholdSignal>;
+using SignalsS12 = SignalPipeline<ThresholdSignal, MeanRevertSignal>;
+
+// Resident set size right now, in KB (peak RSS only ever grows).
+inline long currentRssKB() {
+#if defined(__linux__)
+    long pages = 0, resident = 0;
+    if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        std::fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return peakRssKB();
+#endif
+}
+
+// Swallows reportStats() output so only its formatting cost is timed.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct BenchOptions {
+    std::vector<size_t> ticks{100000, 1000000, 10000000, 100000000};
+    std::vector<size_t> instruments{10, 100, 1000, 10000, 100000};
+    std::vector<size_t> capacities{32, 64, 256, 1024};
+    std::vector<std::string> signals{"S1", "S1-S2", "S1-S3", "S1-S4", "S1-S4+simd"};
+    std::vector<std::string> sweeps{"ticks", "instruments", "capacity", "signals"};
+    size_t base_ticks = 1000000;
+    size_t base_instruments = 10;
+    size_t columnar_above = 10000000;   // feed + orders go columnar at this size
+    int warmup = 1, repeats = 3, threads = 1;
+    bool counter_gen = false, do_export = true;
+    std::string json_path = "hft_bench.json";
+    std::string export_path = "hft_bench_orders.csv";
+};
+
+struct BenchCase {
+    std::string sweep;
+    size_t ticks = 0, instruments = 0;
+    size_t capacity = 0;             // 0 = the pipeline's own window
+    std::string signals = "S1-S4";
+    bool columnar = false;
+};
+
+// Wall times (ms) of one phase across the measured repetitions.
+struct PhaseTimes {
+    std::vector<double> ms;
+    double min() const { return ms.empty() ? 0.0 : *std::min_element(ms.begin(), ms.end()); }
+    double mean() const {
+        double s = 0.0;
+        for (double v : ms) s += v;
+        return ms.empty() ? 0.0 : s / double(ms.size());
+    }
+    double median() const {
+        if (ms.empty()) return 0.0;
+        std::vector<double> v = ms;
+        std::sort(v.begin(), v.end());
+        return v.size() % 2 ? v[v.size() / 2] : 0.5 * (v[v.size() / 2 - 1] + v[v.size() / 2]);
+    }
+};
+
+struct BenchResult {
+    BenchCase c;
+    size_t capacity = 0;             // effective PriceHistory depth
+    PhaseTimes gen, process, report, exporting;
+    size_t orders = 0;
+    long rss_kb = 0, peak_rss_kb = 0;
+
+    double nsPerTick() const { return c.ticks ? process.median() * 1e6 / double(c.ticks) : 0.0; }
+    double ticksPerSec() const { return process.median() > 0 ? double(c.ticks) / (process.median() * 1e-3) : 0.0; }
+    double genNsPerTick() const { return c.ticks ? gen.median() * 1e6 / double(c.ticks) : 0.0; }
+};
+
+template<class Pipeline>
+BenchResult runCase(const BenchCase& c, const BenchOptions& o, bool simd) {
+    using Engine = TradeEngineT<Pipeline>;
+    BenchResult r;
+    r.c = c;
+    r.capacity = std::tuple_size_v<decltype(typename Pipeline::History{}.buf)>;
+    auto since = [](Clock::time_point t) { return std::chrono::duration<double, std::milli>(Clock::now() - t).count(); };
+
+    std::vector<MarketData> feed;
+    MarketDataColumns cols(false);
+    MarketDataFeed generator(feed, int(c.instruments));
+    if (o.counter_gen) {
+        CounterFeedConfig g;
+        g.threads = std::max(1u, std::thread::hardware_concurrency());
+        generator.useCounterRng(g);
+    }
+    NullBuffer null_buf;
+
+    for (int rep = 0; rep < o.warmup + o.repeats; ++rep) {
+        const bool measured = rep >= o.warmup;
+        auto t = Clock::now();
+        if (c.columnar) generator.generateData(int(c.ticks), cols);
+        else generator.generateData(int(c.ticks));
+        const double gen_ms = since(t);
+
+        t = Clock::now();
+        std::unique_ptr<Engine> e = c.columnar ? std::make_unique<Engine>(cols, int(c.instruments), o.threads)
+                                               : std::make_unique<Engine>(feed, int(c.instruments), o.threads);
+        if (c.columnar) e->setColumnarOrders(false);
+        e->setBatchedSignals(simd);
+        e->process();
+        const double proc_ms = since(t);
+        r.rss_kb = std::max(r.rss_kb, currentRssKB());
+
+        t = Clock::now();
+        std::streambuf* saved = cout.rdbuf(&null_buf);
+        e->reportStats();
+        cout.rdbuf(saved);
+        const double report_ms = since(t);
+
+        double export_ms = 0.0;
+        if (o.do_export) {
+            t = Clock::now();
+            e->exportCSV(o.export_path);
+            export_ms = since(t);
+            std::remove(o.export_path.c_str());
+        }
+
+        r.orders = e->orderCount();
+        if (measured) {
+            r.gen.ms.push_back(gen_ms);
+            r.process.ms.push_back(proc_ms);
+            r.report.ms.push_back(report_ms);
+            r.exporting.ms.push_back(export_ms);
+        }
+    }
+    r.peak_rss_kb = peakRssKB();
+    return r;
+}
+
+// Capacities are template arguments, so only this list can be benchmarked.
+template<class P, size_t CAP, size_t... Rest>
+bool runWithCapacity(const BenchCase& c, const BenchOptions& o, bool simd, BenchResult& out) {
+    if (c.capacity == CAP) {
+        if constexpr (CAP >= P::window) {
+            out = runCase<WithCapacity<CAP, P>>(c, o, simd);
+            return true;
+        }
+        return false;
+    }
+    if constexpr (sizeof...(Rest) > 0) return runWithCapacity<P, Rest...>(c, o, simd, out);
+    return false;
+}
+
+template<class P>
+bool runPipeline(const BenchCase& c, const BenchOptions& o, bool simd, BenchResult& out) {
+    if (c.capacity == 0 || c.capacity == P::window) {
+        out = runCase<P>(c, o, simd);
+        return true;
+    }
+    return runWithCapacity<P, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096>(c, o, simd, out);
+}
+
+bool runBenchCase(const BenchCase& c, const BenchOptions& o, BenchResult& out) {
+    if (c.signals == "S1") return runPipeline<SignalsS1>(c, o, false, out);
+    if (c.signals == "S1-S2") return runPipeline<SignalsS12>(c, o, false, out);
+    if (c.signals == "S1-S3") return runPipeline<BuiltinSignals3>(c, o, false, out);
+    if (c.signals == "S1-S4") return runPipeline<BuiltinSignals4>(c, o, false, out);
+    if (c.signals == "S1-S4+simd") {
+        if (c.capacity && c.capacity != BuiltinSignals4::window) return false;   // lane path is fixed to the built-ins
+        out = runCase<BuiltinSignals4>(c, o, true);
+        return true;
+    }
+    return false;
+}
+
+enum class CaseStatus { Ok, NotCompiled, Failed };
+
+// Runs one case in a forked child, so its RSS figures are its own: the parent
+// never holds a feed, and the child's peak RSS (ru_maxrss) does not carry the
+// high-water mark of earlier cases. Results come back over a pipe as doubles:
+// status, capacity, orders, rss_kb, peak_rss_kb, then each phase's runs.
+CaseStatus runIsolated(const BenchCase& c, const BenchOptions& o, BenchResult& out) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fds[2];
+    if (pipe(fds) != 0) { perror("pipe"); return CaseStatus::Failed; }
+    cout << std::flush;
+    const pid_t pid = fork();
+    if (pid < 0) { perror("fork"); close(fds[0]); close(fds[1]); return CaseStatus::Failed; }
+    if (pid == 0) {
+        close(fds[0]);
+        BenchResult r;
+        const bool ok = runBenchCase(c, o, r);
+        std::vector<double> msg{ok ? 1.0 : 0.0, double(r.capacity), double(r.orders), double(r.rss_kb), double(r.peak_rss_kb)};
+        for (const PhaseTimes* p : {&r.gen, &r.process, &r.report, &r.exporting})
+            msg.insert(msg.end(), p->ms.begin(), p->ms.end());   // empty when !ok
+        const char* buf = reinterpret_cast<const char*>(msg.data());
+        for (size_t left = msg.size() * sizeof(double); left > 0;) {
+            const ssize_t w = write(fds[1], buf, left);
+            if (w <= 0) _exit(1);
+            buf += w;
+            left -= size_t(w);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    std::vector<char> bytes;
+    char chunk[4096];
+    for (ssize_t got; (got = read(fds[0], chunk, sizeof(chunk))) != 0;) {
+        if (got < 0) { if (errno == EINTR) continue; break; }
+        bytes.insert(bytes.end(), chunk, chunk + got);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    const size_t runs = size_t(o.repeats), want = 5 + 4 * runs;
+    const bool exited = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    double ok = 0.0;
+    if (bytes.size() >= sizeof(double)) std::memcpy(&ok, bytes.data(), sizeof(double));
+    if (exited && bytes.size() == 5 * sizeof(double) && ok == 0.0) return CaseStatus::NotCompiled;
+    if (!exited || bytes.size() != want * sizeof(double)) {
+        cerr << "Error: " << c.sweep << " case (" << c.ticks << " ticks, " << c.instruments << " instruments) "
+             << (WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status)) : std::string("failed")) << "\n";
+        return CaseStatus::Failed;
+    }
+    std::vector<double> msg(want);
+    std::memcpy(msg.data(), bytes.data(), bytes.size());
+    out = BenchResult{};
+    out.c = c;
+    out.capacity = size_t(msg[1]);
+    out.orders = size_t(msg[2]);
+    out.rss_kb = long(msg[3]);
+    out.peak_rss_kb = long(msg[4]);
+    size_t k = 5;
+    for (PhaseTimes* p : {&out.gen, &out.process, &out.report, &out.exporting}) {
+        p->ms.assign(msg.begin() + long(k), msg.begin() + long(k + runs));
+        k += runs;
+    }
+    return CaseStatus::Ok;
+#else
+    return runBenchCase(c, o, out) ? CaseStatus::Ok : CaseStatus::NotCompiled;
+#endif
+}
+
+std::vector<BenchCase> buildCases(const BenchOptions& o) {
+    std::vector<BenchCase> cases;
+    auto add = [&](const std::string& sweep, size_t ticks, size_t inst, size_t cap, const std::string& sig) {
+        BenchCase c;
+        c.sweep = sweep;
+        c.ticks = ticks;
+        c.instruments = inst;
+        c.capacity = cap;
+        c.signals = sig;
+        c.columnar = ticks >= o.columnar_above;
+        cases.push_back(c);
+    };
+    for (const std::string& s : o.sweeps) {
+        if (s == "ticks") for (size_t t : o.ticks) add(s, t, o.base_instruments, 0, "S1-S4");
+        else if (s == "instruments") for (size_t n : o.instruments) add(s, o.base_ticks, n, 0, "S1-S4");
+        else if (s == "capacity") for (size_t cap : o.capacities) add(s, o.base_ticks, o.base_instruments, cap, "S1-S4");
+        else if (s == "signals") for (const std::string& sig : o.signals) add(s, o.base_ticks, o.base_instruments, 0, sig);
+        else cerr << "Warning: unknown sweep '" << s << "'\n";
+    }
+    return cases;
+}
+
+void printHeader() {
+    cout << std::left << std::setw(12) << "sweep" << std::right << std::setw(11) << "ticks" << std::setw(8) << "instr"
+         << std::setw(6) << "cap" << "  " << std::left << std::setw(11) << "signals" << std::setw(9) << "layout" << std::right
+         << std::setw(10) << "gen ms" << std::setw(10) << "proc ms" << std::setw(9) << "rep ms" << std::setw(10) << "exp ms"
+         << std::setw(10) << "Mticks/s" << std::setw(9) << "ns/tick" << std::setw(11) << "orders" << std::setw(10) << "rss MB" << "\n";
+}
+
+void printRow(const BenchResult& r) {
+    cout << std::left << std::setw(12) << r.c.sweep << std::right << std::setw(11) << r.c.ticks << std::setw(8) << r.c.instruments
+         << std::setw(6) << r.capacity << "  " << std::left << std::setw(11) << r.c.signals
+         << std::setw(9) << (r.c.columnar ? "columnar" : "row") << std::right << std::fixed << std::setprecision(1)
+         << std::setw(10) << r.gen.median() << std::setw(10) << r.process.median() << std::setw(9) << r.report.median()
+         << std::setw(10) << r.exporting.median() << std::setprecision(2) << std::setw(10) << r.ticksPerSec() / 1e6
+         << std::setw(9) << r.nsPerTick() << std::setw(11) << r.orders << std::setprecision(1)
+         << std::setw(10) << double(r.rss_kb) / 1024.0 << "\n" << std::flush;
+    cout.unsetf(std::ios::floatfield);
+    cout << std::setprecision(6);
+}
+
+static std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+bool writeJson(const std::string& path, const BenchOptions& o, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out) return false;
+    char when[32] = "";
+    const std::time_t now = std::time(nullptr);
+    std::strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    char host[256] = "unknown";
+#if defined(__unix__) || defined(__APPLE__)
+    gethostname(host, sizeof(host) - 1);
+#endif
+    std::string isa = "scalar";
+#if defined(__AVX512F__)
+    isa = "avx512";
+#elif defined(__AVX2__)
+    isa = "avx2";
+#endif
+    auto phase = [&](const char* name, const PhaseTimes& p, bool last = false) {
+        out << "      \"" << name << "\": {\"min\": " << p.min() << ", \"median\": " << p.median()
+            << ", \"mean\": " << p.mean() << ", \"runs\": [";
+        for (size_t i = 0; i < p.ms.size(); ++i) out << (i ? ", " : "") << p.ms[i];
+        out << "]}" << (last ? "\n" : ",\n");
+    };
+    out << std::setprecision(9);
+    out << "{\n  \"build\": {\"compiler\": \"" << jsonEscape(__VERSION__) << "\", \"isa\": \"" << isa
+        << "\", \"built\": \"" << __DATE__ << " " << __TIME__ << "\", \"vol_signal\": " << ENABLE_VOL_SIGNAL
+        << ", \"tsc_profile\": " << ENABLE_TSC_PROFILE << "},\n";
+    out << "  \"host\": {\"name\": \"" << jsonEscape(host) << "\", \"cpus\": " << std::thread::hardware_concurrency()
+        << ", \"date\": \"" << when << "\"},\n";
+    out << "  \"options\": {\"warmup\": " << o.warmup << ", \"repeats\": " << o.repeats << ", \"threads\": " << o.threads
+        << ", \"generator\": \"" << (o.counter_gen ? "counter" : "mt19937_64") << "\", \"export\": "
+        << (o.do_export ? "true" : "false") << ", \"columnar_above\": " << o.columnar_above << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\n      \"sweep\": \"" << r.c.sweep << "\", \"ticks\": " << r.c.ticks << ", \"instruments\": "
+            << r.c.instruments << ", \"capacity\": " << r.capacity << ", \"signals\": \"" << r.c.signals
+            << "\", \"layout\": \"" << (r.c.columnar ? "columnar" : "row") << "\",\n";
+        phase("generate_ms", r.gen);
+        phase("process_ms", r.process);
+        phase("report_ms", r.report);
+        phase("export_ms", r.exporting);
+        out << "      \"ticks_per_sec\": " << r.ticksPerSec() << ", \"ns_per_tick\": " << r.nsPerTick()
+            << ", \"generate_ns_per_tick\": " << r.genNsPerTick() << ",\n";
+        out << "      \"orders\": " << r.orders << ", \"rss_kb\": " << r.rss_kb << ", \"peak_rss_kb\": " << r.peak_rss_kb
+            << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return bool(out);
+}
+
+template<class T, class Parse>
+std::vector<T> parseList(const std::string& s, Parse parse) {
+    std::vector<T> v;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t comma = s.find(',', pos);
+        if (comma == std::string::npos) comma = s.size();
+        if (comma > pos) v.push_back(parse(s.substr(pos, comma - pos)));
+        pos = comma + 1;
+    }
+    return v;
+}
+
+// Accepts "1e6" as well as "1000000".
+static size_t parseCount(const std::string& s) { return size_t(std::llround(std::stod(s))); }
+
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);
+    BenchOptions o;
+    auto sizes = [](const std::string& s) { return parseList<size_t>(s, parseCount); };
+    auto names = [](const std::string& s) { return parseList<std::string>(s, [](const std::string& x) { return x; }); };
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--ticks" && i+1 < argc) o.ticks = sizes(argv[++i]);
+        else if (arg == "--instruments" && i+1 < argc) o.instruments = sizes(argv[++i]);
+        else if (arg == "--capacity" && i+1 < argc) o.capacities = sizes(argv[++i]);
+        else if (arg == "--signals" && i+1 < argc) o.signals = names(argv[++i]);
+        else if (arg == "--sweeps" && i+1 < argc) o.sweeps = names(argv[++i]);
+        else if (arg == "--base-ticks" && i+1 < argc) o.base_ticks = parseCount(argv[++i]);
+        else if (arg == "--base-instruments" && i+1 < argc) o.base_instruments = parseCount(argv[++i]);
+        else if (arg == "--columnar-above" && i+1 < argc) o.columnar_above = parseCount(argv[++i]);
+        else if (arg == "--warmup" && i+1 < argc) o.warmup = std::max(0, stoi(argv[++i]));
+        else if (arg == "--repeats" && i+1 < argc) o.repeats = std::max(1, stoi(argv[++i]));
+        else if (arg == "--threads" && i+1 < argc) o.threads = std::max(1, stoi(argv[++i]));
+        else if (arg == "--gen" && i+1 < argc) {
+            const string gen = argv[++i];
+            if (gen != "mt" && gen != "counter") { cerr << "Error: --gen must be mt or counter, got '" << gen << "'\n"; return 1; }
+            o.counter_gen = gen == "counter";
+        }
+        else if (arg == "--no-export") o.do_export = false;
+        else if (arg == "--json" && i+1 < argc) o.json_path = argv[++i];
+        else if (arg == "--help" || arg == "-h") {
+            cout << "usage: hft_bench [--sweeps ticks,instruments,capacity,signals] [--ticks LIST] [--instruments LIST]\n"
+                 << "                 [--capacity LIST] [--signals S1,S1-S2,S1-S3,S1-S4,S1-S4+simd]\n"
+                 << "                 [--base-ticks N] [--base-instruments N] [--columnar-above N]\n"
+                 << "                 [--warmup N] [--repeats N] [--threads N] [--gen mt|counter] [--no-export] [--json PATH]\n";
+            return 0;
+        }
+        else { cerr << "Error: unknown option " << arg << " (see --help)\n"; return 1; }
+    }
+
+    const std::vector<BenchCase> cases = buildCases(o);
+    cout << "hft_bench: " << cases.size() << " cases, " << o.warmup << " warmup + " << o.repeats
+         << " measured runs each, " << o.threads << " engine thread(s)\n";
+    printHeader();
+    std::vector<BenchResult> results;
+    for (const BenchCase& c : cases) {
+        BenchResult r;
+        const CaseStatus st = runIsolated(c, o, r);
+        if (st == CaseStatus::NotCompiled)
+            cerr << "Warning: skipping " << c.sweep << " case: signals " << c.signals << " with capacity " << c.capacity
+                 << " is not a compiled combination\n";
+        if (st != CaseStatus::Ok) continue;
+        printRow(r);
+        results.push_back(std::move(r));
+    }
+    if (!writeJson(o.json_path, o, results)) {
+        cerr << "Error: cannot write " << o.json_path << "\n";
+        return 1;
+    }
+    cout << "Results: " << results.size() << " cases to " << o.json_path << "\n";
+    return 0;
+}
@@ -0,0 +1,242 @@
+// Live metrics segment shared between hft_sim (writer) and hft_mon (reader).
+//
+// One POSIX shared-memory object laid out as
+//   MetricsHeader | MetricsShard[n_shards] | MetricsInstrument[n_instruments]
+// Every shard block and every instrument record has exactly one writer (the
+// engine thread that owns it). Counters are updated with a relaxed load and
+// store, never a locked read-modify-write. Readers see each 64-bit value whole
+// and compute rates from deltas. Per-instrument records hold several related
+// fields, so they sit behind a seqlock: the writer makes the sequence odd,
+// stores the fields and makes it even again; a reader retries until it sees
+// the same even sequence before and after its copy. Neither side makes a
+// syscall or takes a lock after the segment is mapped.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr char METRICS_MAGIC[8] = {'H', 'F', 'T', 'M', 'E', 'T', 'R', '1'};
+constexpr uint32_t METRICS_VERSION = 1;
+constexpr int METRICS_MAX_SIGNALS = 8;
+constexpr int METRICS_LAT_BUCKETS = 64;   // bucket b holds latencies in [2^(b-1), 2^b) ns
+
+enum MetricsState : uint32_t { METRICS_STARTING = 0, METRICS_RUNNING = 1, METRICS_DONE = 2 };
+
+struct MetricsHeader {
+    char magic[8];                 // written last by the creator
+    uint32_t version;
+    uint32_t n_shards, n_instruments, n_signals;
+    uint64_t shard_offset, instrument_offset, total_bytes;
+    int64_t pid;
+    char signal_names[METRICS_MAX_SIGNALS][24];
+    std::atomic<uint32_t> state;
+    std::atomic<int64_t> state_changed_ns;   // steady_clock of the last state change
+};
+
+// Counters of one engine shard.
+struct alignas(64) MetricsShard {
+    std::atomic<uint64_t> ticks, orders, buys;
+    std::atomic<uint64_t> signals[METRICS_MAX_SIGNALS];   // orders attributed per signal
+    std::atomic<uint64_t> latency[METRICS_LAT_BUCKETS];   // tick-to-trade, log2 buckets
+};
+
+// Latest state of one instrument, guarded by `seq`.
+struct alignas(64) MetricsInstrument {
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> last_mask;        // signals behind the last order
+    std::atomic<uint64_t> ticks, orders;
+    std::atomic<int64_t> position;          // buys - sells, one unit per order
+    std::atomic<double> last_price, avg_price;
+};
+
+// Plain copy of a MetricsInstrument, as read by the monitor.
+struct InstrumentSnapshot {
+    uint32_t last_mask;
+    uint64_t ticks, orders;
+    int64_t position;
+    double last_price, avg_price;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+              "metrics counters must be plain loads/stores to be shared across processes");
+
+// Single-writer increment: a load and a store, no lock prefix.
+template<class T>
+inline void metricsAdd(std::atomic<T>& c, T d = 1) {
+    c.store(c.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+}
+
+inline int metricsLatencyBucket(int64_t ns) {
+    return ns > 0 ? 64 - __builtin_clzll(uint64_t(ns)) : 0;
+}
+
+// Writer side of the instrument seqlock.
+inline uint32_t metricsBeginWrite(MetricsInstrument& m) {
+    const uint32_t s = m.seq.load(std::memory_order_relaxed);
+    m.seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return s;
+}
+inline void metricsEndWrite(MetricsInstrument& m, uint32_t s) {
+    m.seq.store(s + 2, std::memory_order_release);
+}
+
+// Reader side; false if the writer kept the record busy for every attempt.
+inline bool metricsRead(const MetricsInstrument& m, InstrumentSnapshot& out, int attempts = 64) {
+    for (int i = 0; i < attempts; ++i) {
+        const uint32_t s0 = m.seq.load(std::memory_order_acquire);
+        if (s0 & 1) continue;
+        out.last_mask = m.last_mask.load(std::memory_order_relaxed);
+        out.ticks = m.ticks.load(std::memory_order_relaxed);
+        out.orders = m.orders.load(std::memory_order_relaxed);
+        out.position = m.position.load(std::memory_order_relaxed);
+        out.last_price = m.last_price.load(std::memory_order_relaxed);
+        out.avg_price = m.avg_price.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m.seq.load(std::memory_order_relaxed) == s0) return true;
+    }
+    return false;
+}
+
+// Mapping of one segment. The creator sizes and zeroes it and unlinks the
+// name when destroyed; a mapping that is still open elsewhere stays valid.
+class MetricsSegment {
+public:
+    static std::unique_ptr<MetricsSegment> create(const std::string& name, int n_shards, int n_instruments,
+                                                  const std::vector<std::string>& signals) {
+#if defined(__unix__) || defined(__APPLE__)
+        const uint64_t shard_off = (sizeof(MetricsHeader) + 63) & ~uint64_t(63);
+        const uint64_t inst_off = shard_off + uint64_t(n_shards) * sizeof(MetricsShard);
+        const uint64_t total = inst_off + uint64_t(n_instruments) * sizeof(MetricsInstrument);
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            if (ownerAlive(name)) {
+                std::cerr << "Error: metrics segment " << name << " is in use by a running process"
+                          << " (remove /dev/shm" << name << " if it is not)\n";
+                return nullptr;
+            }
+            // left behind by a run that died without unlinking it
+            shm_unlink(name.c_str());
+            fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        }
+        if (fd < 0) { perror("shm_open"); return nullptr; }
+        if (ftruncate(fd, off_t(total)) != 0) { perror("ftruncate"); close(fd); shm_unlink(name.c_str()); return nullptr; }
+        void* p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) { perror("mmap"); shm_unlink(name.c_str()); return nullptr; }
+        std::unique_ptr<MetricsSegment> seg(new MetricsSegment(name, p, total, true));
+        MetricsHeader& h = seg->header();   // ftruncate gave us zeroed memory
+        h.version = METRICS_VERSION;
+        h.n_shards = uint32_t(n_shards);
+        h.n_instruments = uint32_t(n_instruments);
+        h.n_signals = uint32_t(std::min<size_t>(signals.size(), METRICS_MAX_SIGNALS));
+        h.shard_offset = shard_off;
+        h.instrument_offset = inst_off;
+        h.total_bytes = total;
+        h.pid = int64_t(getpid());
+        for (uint32_t i = 0; i < h.n_signals; ++i)
+            std::strncpy(h.signal_names[i], signals[i].c_str(), sizeof(h.signal_names[i]) - 1);
+        seg->setState(METRICS_STARTING);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(h.magic, METRICS_MAGIC, sizeof(METRICS_MAGIC));
+        return seg;
+#else
+        (void)name; (void)n_shards; (void)n_instruments; (void)signals;
+        std::cerr << "Error: shared-memory metrics need a POSIX system\n";
+        return nullptr;
+#endif
+    }
+
+    // Read-only mapping of an existing segment; nullptr if it is missing,
+    // still being created, or from another layout version.
+    static std::unique_ptr<MetricsSegment> attach(const std::string& name) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(MetricsHeader)) { close(fd); return nullptr; }
+        void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return nullptr;
+        std::unique_ptr<MetricsSegment> seg(new MetricsSegment(name, p, size_t(st.st_size), false));
+        const MetricsHeader& h = seg->header();
+        if (std::memcmp(h.magic, METRICS_MAGIC, sizeof(METRICS_MAGIC)) != 0) return nullptr;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (h.version != METRICS_VERSION || h.total_bytes > size_t(st.st_size)) return nullptr;
+        return seg;
+#else
+        (void)name;
+        return nullptr;
+#endif
+    }
+
+    ~MetricsSegment() {
+#if defined(__unix__) || defined(__APPLE__)
+        munmap(base, bytes);
+        if (owner) shm_unlink(seg_name.c_str());
+#endif
+    }
+
+    MetricsSegment(const MetricsSegment&) = delete;
+    MetricsSegment& operator=(const MetricsSegment&) = delete;
+
+    MetricsHeader& header() { return *static_cast<MetricsHeader*>(base); }
+    const MetricsHeader& header() const { return *static_cast<const MetricsHeader*>(base); }
+    MetricsShard& shard(int i) {
+        return reinterpret_cast<MetricsShard*>(static_cast<char*>(base) + header().shard_offset)[i];
+    }
+    const MetricsShard& shard(int i) const {
+        return reinterpret_cast<const MetricsShard*>(static_cast<const char*>(base) + header().shard_offset)[i];
+    }
+    MetricsInstrument& instrument(int i) {
+        return reinterpret_cast<MetricsInstrument*>(static_cast<char*>(base) + header().instrument_offset)[i];
+    }
+    const MetricsInstrument& instrument(int i) const {
+        return reinterpret_cast<const MetricsInstrument*>(static_cast<const char*>(base) + header().instrument_offset)[i];
+    }
+
+    void setState(MetricsState s) {
+        header().state_changed_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+        header().state.store(s, std::memory_order_release);
+    }
+    MetricsState state() const { return MetricsState(header().state.load(std::memory_order_acquire)); }
+
+    const std::string& name() const { return seg_name; }
+    size_t size() const { return bytes; }
+
+private:
+    MetricsSegment(std::string n, void* p, size_t len, bool own) : seg_name(std::move(n)), base(p), bytes(len), owner(own) {}
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Whether the process that created segment `name` still exists. A segment
+    // that cannot be attached (mid-creation or another layout) counts as live.
+    static bool ownerAlive(const std::string& name) {
+        auto seg = attach(name);
+        if (!seg) return true;
+        const pid_t pid = pid_t(seg->header().pid);
+        return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+    }
+#endif
+
+    std::string seg_name;
+    void* base;
+    size_t bytes;
+    bool owner;
+};
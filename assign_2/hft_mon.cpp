@@ -0,0 +1,136 @@
+// hft_mon: attach to the live metrics segment of a running hft_sim
+// (--metrics NAME) and print rates once per interval. Read-only; the engine
+// never waits on it.
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "hft_metrics.h"
+using namespace std;
+
+using Clock = std::chrono::steady_clock;
+
+// Sum of all shard blocks at one instant.
+struct Totals {
+    uint64_t ticks = 0, orders = 0, buys = 0;
+    uint64_t signals[METRICS_MAX_SIGNALS] = {};
+    uint64_t latency[METRICS_LAT_BUCKETS] = {};
+};
+
+static Totals readTotals(const MetricsSegment& seg) {
+    Totals t;
+    for (uint32_t s = 0; s < seg.header().n_shards; ++s) {
+        const MetricsShard& m = seg.shard(int(s));
+        t.ticks += m.ticks.load(std::memory_order_relaxed);
+        t.orders += m.orders.load(std::memory_order_relaxed);
+        t.buys += m.buys.load(std::memory_order_relaxed);
+        for (int i = 0; i < METRICS_MAX_SIGNALS; ++i) t.signals[i] += m.signals[i].load(std::memory_order_relaxed);
+        for (int b = 0; b < METRICS_LAT_BUCKETS; ++b) t.latency[b] += m.latency[b].load(std::memory_order_relaxed);
+    }
+    return t;
+}
+
+// Upper bound (ns) of the log2 bucket holding quantile q of the interval.
+static uint64_t bucketQuantile(const Totals& now, const Totals& prev, double q) {
+    uint64_t total = 0;
+    for (int b = 0; b < METRICS_LAT_BUCKETS; ++b) total += now.latency[b] - prev.latency[b];
+    if (!total) return 0;
+    const uint64_t rank = uint64_t(q * double(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_LAT_BUCKETS; ++b) {
+        seen += now.latency[b] - prev.latency[b];
+        if (seen >= rank) return b ? (uint64_t(1) << b) - 1 : 0;
+    }
+    return ~uint64_t(0);
+}
+
+static string rate(double v) {
+    ostringstream os;
+    os << std::fixed << std::setprecision(1);
+    if (v >= 1e6) os << v / 1e6 << "M";
+    else if (v >= 1e3) os << v / 1e3 << "k";
+    else os << v;
+    return os.str();
+}
+
+int main(int argc, char** argv) {
+    string name = "/hft_sim";
+    int interval_ms = 1000;
+    int top = 5;
+    bool once = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--interval" && i+1 < argc) interval_ms = max(10, stoi(argv[++i]));
+        else if (arg == "--top" && i+1 < argc) top = stoi(argv[++i]);
+        else if (arg == "--once") once = true;
+        else if (arg == "--help" || arg == "-h") {
+            cout << "usage: hft_mon [NAME] [--interval MS] [--top K] [--once]\n"
+                 << "  NAME        segment given to hft_sim --metrics (default /hft_sim)\n"
+                 << "  --interval  print period in ms (default 1000)\n"
+                 << "  --top       instruments to show, most active first (default 5)\n"
+                 << "  --once      print one snapshot of the totals and exit\n";
+            return 0;
+        }
+        else name = arg;
+    }
+    if (name[0] != '/') name = "/" + name;
+
+    std::unique_ptr<MetricsSegment> seg;
+    for (bool waiting = false; !(seg = MetricsSegment::attach(name));) {
+        if (once) { cerr << "Error: no metrics segment " << name << "\n"; return 1; }
+        if (!waiting) { cout << "waiting for " << name << " ...\n" << std::flush; waiting = true; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    const MetricsHeader& h = seg->header();
+    cout << "attached " << name << " (pid " << h.pid << ", " << h.n_shards << " shards, "
+         << h.n_instruments << " instruments, " << seg->size() / 1024 << " KB)\n";
+
+    Totals prev = readTotals(*seg);
+    auto t_prev = Clock::now(), t0 = t_prev;
+    for (;;) {
+        if (!once) std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        const bool done = seg->state() == METRICS_DONE;   // acquire: totals below are final
+        const Totals now = readTotals(*seg);
+        const auto t_now = Clock::now();
+        const double dt = std::max(1e-9, std::chrono::duration<double>(t_now - t_prev).count());
+
+        cout << "[" << std::fixed << std::setprecision(1)
+             << std::chrono::duration<double>(t_now - t0).count() << "s] "
+             << "ticks " << now.ticks << " (" << rate(double(now.ticks - prev.ticks) / dt) << "/s)  "
+             << "orders " << now.orders << " (" << rate(double(now.orders - prev.orders) / dt) << "/s, buys "
+             << now.buys << ")  ";
+        for (uint32_t i = 0; i < h.n_signals; ++i)
+            cout << h.signal_names[i] << " " << rate(double(now.signals[i] - prev.signals[i]) / dt) << "/s  ";
+        const Totals& base = once ? Totals{} : prev;
+        cout << "lat p50/p99 <= " << bucketQuantile(now, base, 0.50) << "/" << bucketQuantile(now, base, 0.99)
+             << " ns" << (done ? "  [done]" : "") << "\n";
+
+        if (top > 0) {
+            // Most active instruments by ticks; each record read under its seqlock.
+            vector<pair<uint64_t, uint32_t>> active;
+            vector<InstrumentSnapshot> snaps(h.n_instruments);
+            for (uint32_t i = 0; i < h.n_instruments; ++i)
+                if (metricsRead(seg->instrument(int(i)), snaps[i])) active.emplace_back(snaps[i].ticks, i);
+            const size_t k = std::min<size_t>(size_t(top), active.size());
+            std::partial_sort(active.begin(), active.begin() + k, active.end(),
+                              [](auto& a, auto& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+            for (size_t j = 0; j < k; ++j) {
+                const InstrumentSnapshot& s = snaps[active[j].second];
+                cout << "    id " << std::setw(6) << active[j].second << "  ticks " << std::setw(10) << s.ticks
+                     << "  px " << std::setprecision(4) << std::setw(9) << s.last_price
+                     << "  avg " << std::setw(9) << s.avg_price << "  orders " << std::setw(8) << s.orders
+                     << "  pos " << std::setw(7) << s.position << "  mask 0x" << std::hex << s.last_mask
+                     << std::dec << "\n";
+            }
+        }
+        cout << std::flush;
+        cout.unsetf(std::ios::floatfield);
+        if (done || once) break;
+        prev = now;
+        t_prev = t_now;
+    }
+    return 0;
+}
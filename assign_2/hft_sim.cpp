@@ -1,20 +1,52 @@
 #include <iostream>
 #include <vector>
 #include <array>
+#include <bit>
 #include <chrono>
 #include <random>
 #include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iomanip>
+#include <atomic>
+#include <charconv>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+#include <sys/resource.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "hft_metrics.h"
 using namespace std;
 
 using Clock = std::chrono::high_resolution_clock;
 using ns = std::chrono::nanoseconds;
 using ms = std::chrono::milliseconds;
 
+#ifndef ENABLE_TSC_PROFILE
+#define ENABLE_TSC_PROFILE 0  // set to 1 for a per-stage cycle breakdown of the tick path
+#endif
+
 #ifndef ENABLE_VOL_SIGNAL
-#define ENABLE_VOL_SIGNAL 1   // set to 0 to disable bonus volatility signal
+#define ENABLE_VOL_SIGNAL 1   // set to 0 to drop VolBreakoutSignal from DefaultSignals
 #endif
 
 // --------------------------- Market Data ---------------------------
@@ -24,20 +56,442 @@ struct alignas(64) MarketData {
     Clock::time_point timestamp;
 };
 
+// Fixed-point price unit for the columnar stores: 1e-6 of a currency unit.
+constexpr int64_t PRICE_SCALE = 1000000;
+
+inline int64_t toFixed(double px) { return std::llround(px * double(PRICE_SCALE)); }
+inline double fromFixed(int64_t fp) { return double(fp) / double(PRICE_SCALE); }
+inline int64_t toNanos(Clock::time_point t) {
+    return std::chrono::time_point_cast<ns>(t).time_since_epoch().count();
+}
+inline Clock::time_point fromNanos(int64_t t) {
+    return Clock::time_point(std::chrono::duration_cast<Clock::duration>(ns(t)));
+}
+
+// Columnar (structure-of-arrays) feed: one contiguous array per field, 20 bytes
+// per tick instead of a 64-byte MarketData line. With fixed_point set, prices
+// are kept as int64 in PRICE_SCALE units and decoded on read.
+struct MarketDataColumns {
+    bool fixed_point = false;
+    std::vector<int32_t> instrument_id;
+    std::vector<double> price;      // !fixed_point
+    std::vector<int64_t> price_fp;  // fixed_point
+    std::vector<int64_t> timestamp_ns;
+
+    explicit MarketDataColumns(bool fixed = false) : fixed_point(fixed) {}
+
+    size_t size() const { return instrument_id.size(); }
+
+    void reserve(size_t n) {
+        instrument_id.reserve(n);
+        (fixed_point ? void(price_fp.reserve(n)) : void(price.reserve(n)));
+        timestamp_ns.reserve(n);
+    }
+
+    void clear() {
+        instrument_id.clear(); price.clear(); price_fp.clear(); timestamp_ns.clear();
+    }
+
+    inline void push(const MarketData& md) {
+        instrument_id.push_back(md.instrument_id);
+        if (fixed_point) price_fp.push_back(toFixed(md.price));
+        else price.push_back(md.price);
+        timestamp_ns.push_back(toNanos(md.timestamp));
+    }
+
+    inline int idAt(size_t i) const { return instrument_id[i]; }
+
+    // Rebuild one tick; the engine only ever holds it in registers.
+    inline MarketData operator[](size_t i) const {
+        MarketData md;
+        md.instrument_id = instrument_id[i];
+        md.price = fixed_point ? fromFixed(price_fp[i]) : price[i];
+        md.timestamp = fromNanos(timestamp_ns[i]);
+        return md;
+    }
+
+    size_t bytes() const {
+        return instrument_id.capacity() * sizeof(int32_t) + price.capacity() * sizeof(double)
+             + price_fp.capacity() * sizeof(int64_t) + timestamp_ns.capacity() * sizeof(int64_t);
+    }
+};
+
+// --------------------------- Counter-Based Generator ---------------------------
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"):
+// ten rounds of a keyed bijection over a 128-bit counter. Draw i is a pure
+// function of (seed, i), so any slice of the stream can be produced on any
+// thread with no carried state.
+constexpr uint32_t PHILOX_M0 = 0xD2511F53u, PHILOX_M1 = 0xCD9E8D57u;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9u, PHILOX_W1 = 0xBB67AE85u;
+
+// Branch-free ln(u) for u in (0, 1]: exponent from the bits, mantissa folded
+// into [sqrt(1/2), sqrt(2)), then the atanh series in s = (m-1)/(m+1)
+// (|s| < 0.172, ~1e-15 relative error). Plain arithmetic, so loops vectorize.
+inline double counterLog(double u) {
+    const uint64_t bits = std::bit_cast<uint64_t>(u);
+    double e = double(int32_t(bits >> 52) - 1023);
+    double m = std::bit_cast<double>((bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull);
+    const bool fold = m > 1.4142135623730951;
+    m = fold ? m * 0.5 : m;
+    e = fold ? e + 1.0 : e;
+    const double s = (m - 1.0) / (m + 1.0), s2 = s * s;
+    double p = 1.0 / 21;
+    p = p * s2 + 1.0 / 19; p = p * s2 + 1.0 / 17; p = p * s2 + 1.0 / 15; p = p * s2 + 1.0 / 13;
+    p = p * s2 + 1.0 / 11; p = p * s2 + 1.0 / 9;  p = p * s2 + 1.0 / 7;  p = p * s2 + 1.0 / 5;
+    p = p * s2 + 1.0 / 3;  p = p * s2 + 1.0;
+    return e * 0.6931471805599453 + 2.0 * s * p;
+}
+
+// cos/sin of 2*pi*t for t in [0, 1). The quadrant comes straight from t, so
+// the polynomial argument stays within +-pi/4 and needs no range reduction.
+inline void counterSinCos2Pi(double t, double& sn, double& cs) {
+    const double q4 = t * 4.0;
+    const int q = int(q4);                       // 0..3
+    const double x = (q4 - double(q) - 0.5) * 1.5707963267948966;
+    const double x2 = x * x;
+    double sp = -1.0 / 1307674368000.0;          // sin: x - x^3/3! + ... - x^15/15!
+    sp = sp * x2 + 1.0 / 6227020800.0; sp = sp * x2 - 1.0 / 39916800.0; sp = sp * x2 + 1.0 / 362880.0;
+    sp = sp * x2 - 1.0 / 5040.0; sp = sp * x2 + 1.0 / 120.0; sp = sp * x2 - 1.0 / 6.0; sp = sp * x2 + 1.0;
+    const double sx = sp * x;
+    double cp = -1.0 / 87178291200.0;            // cos: 1 - x^2/2! + ... - x^14/14!
+    cp = cp * x2 + 1.0 / 479001600.0; cp = cp * x2 - 1.0 / 3628800.0; cp = cp * x2 + 1.0 / 40320.0;
+    cp = cp * x2 - 1.0 / 720.0; cp = cp * x2 + 1.0 / 24.0; cp = cp * x2 - 0.5; cp = cp * x2 + 1.0;
+    const double cx = cp;
+    // Rotate by the quadrant centre (q + 1/2) * pi/2: cos/sin there are +-sqrt(1/2).
+    constexpr double H = 0.7071067811865476;
+    const double c0 = (q == 0 || q == 3) ? H : -H, s0 = (q < 2) ? H : -H;
+    cs = c0 * cx - s0 * sx;
+    sn = s0 * cx + c0 * sx;
+}
+
+// sqrt over non-negative values. std::sqrt's errno path keeps GCC from
+// vectorizing a loop around it; the sqrt instructions themselves don't need it.
+inline void sqrtInPlace(double* v, size_t n) {
+    size_t i = 0;
+#if defined(__AVX512F__)
+    for (; i + 8 <= n; i += 8) _mm512_storeu_pd(v + i, _mm512_maskz_sqrt_pd(0xFF, _mm512_loadu_pd(v + i)));
+#elif defined(__AVX2__)
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(v + i, _mm256_sqrt_pd(_mm256_loadu_pd(v + i)));
+#elif defined(__SSE2__)
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(v + i, _mm_sqrt_pd(_mm_loadu_pd(v + i)));
+#endif
+    for (; i < n; ++i) v[i] = std::sqrt(v[i]);
+}
+
+// One Philox block per (c0, c1, c2, c3) counter, SoA in; Box-Muller turns
+// each block into two standard normals, out[2i] and out[2i+1].
+inline void philoxNormals(const uint32_t* c0, const uint32_t* c1, const uint32_t* c2, const uint32_t* c3,
+                          size_t n, uint64_t seed, double* out) {
+    constexpr size_t B = 64;
+    alignas(64) double rad[B], cs[B], sn[B];
+    for (size_t i0 = 0; i0 < n; i0 += B) {
+        const size_t m = std::min(B, n - i0);
+        for (size_t i = 0; i < m; ++i) {
+            uint32_t x0 = c0[i0 + i], x1 = c1[i0 + i], x2 = c2[i0 + i], x3 = c3[i0 + i];
+            uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+            for (int r = 0; r < 10; ++r) {
+                const uint64_t p0 = uint64_t(PHILOX_M0) * x0, p1 = uint64_t(PHILOX_M1) * x2;
+                const uint32_t y0 = uint32_t(p1 >> 32) ^ x1 ^ k0, y2 = uint32_t(p0 >> 32) ^ x3 ^ k1;
+                x1 = uint32_t(p1); x3 = uint32_t(p0); x0 = y0; x2 = y2;
+                k0 += PHILOX_W0; k1 += PHILOX_W1;
+            }
+            // 52 random mantissa bits -> [1, 2); u1 in (0, 1], u2 in [0, 1).
+            const uint64_t ma = ((uint64_t(x1) << 32) | x0) >> 12, mb = ((uint64_t(x3) << 32) | x2) >> 12;
+            const double u1 = 2.0 - std::bit_cast<double>(ma | 0x3FF0000000000000ull);
+            const double u2 = std::bit_cast<double>(mb | 0x3FF0000000000000ull) - 1.0;
+            rad[i] = -2.0 * counterLog(u1);
+            counterSinCos2Pi(u2, sn[i], cs[i]);
+        }
+        sqrtInPlace(rad, m);
+        for (size_t i = 0; i < m; ++i) {
+            out[2 * (i0 + i)] = rad[i] * cs[i];
+            out[2 * (i0 + i) + 1] = rad[i] * sn[i];
+        }
+    }
+}
+
+// In-place Cholesky of a symmetric n x n matrix (row-major); the lower
+// triangle becomes L with A = L L^T, the upper triangle is zeroed. Returns
+// false if A is not positive definite.
+inline bool choleskyFactor(std::vector<double>& a, int n) {
+    for (int j = 0; j < n; ++j) {
+        double d = a[size_t(j) * n + j];
+        for (int k = 0; k < j; ++k) d -= a[size_t(j) * n + k] * a[size_t(j) * n + k];
+        if (!(d > 0.0)) return false;
+        d = std::sqrt(d);
+        a[size_t(j) * n + j] = d;
+        for (int i = j + 1; i < n; ++i) {
+            double s = a[size_t(i) * n + j];
+            for (int k = 0; k < j; ++k) s -= a[size_t(i) * n + k] * a[size_t(j) * n + k];
+            a[size_t(i) * n + j] = s / d;
+        }
+        for (int k = j + 1; k < n; ++k) a[size_t(j) * n + k] = 0.0;
+    }
+    return true;
+}
+
+struct CounterFeedConfig {
+    uint64_t seed = 0xC0FFEE;
+    double rho = 0.0;        // shock correlation inside a block
+    int corr_block = 64;     // instruments per correlated block
+    unsigned threads = 1;
+};
+
+// Same OU-style model as the mt19937 feed (pull toward 150 + N(0, 0.02) at
+// kappa = 0.02, N(0, 0.5) shocks, clamp to 50..500, ids round robin), driven
+// by counters instead of a serial engine. Round r is ticks [r*n, (r+1)*n);
+// shocks for round r and instrument j are keyed by (seed, r, j), and within a
+// block of instruments they are correlated through a Cholesky factor L of the
+// block's correlation matrix (eps = 0.5 * L z).
+//
+// The walk itself is recursive, so rounds are cut into chunks of CHUNK
+// rounds. Each chunk restarts from the mean, and its path is lifted by the
+// previous chunk's end point decayed by (1 - kappa)^k. What is dropped is
+// (1 - kappa)^CHUNK ~ 1e-9 of the state two chunks back. Any chunk therefore
+// needs at most one chunk of warm-up, and every value is a fixed function of
+// the seed and tick index. The split over threads only decides who computes it.
+// Block-by-block output goes through a Cursor that keeps the walk state
+// between calls, so consecutive blocks pay no warm-up at all.
+class CounterFeed {
+public:
+    static constexpr int CHUNK = 1024;    // rounds per chunk
+    static constexpr double KAPPA = 0.02, DRIFT_SD = 0.02, SHOCK_SD = 0.5, MEAN = 150.0;
+
+    CounterFeed(int n_instruments, const CounterFeedConfig& c) : cfg(c), n(std::max(n_instruments, 1)) {
+        G = std::clamp(cfg.corr_block, 1, n);
+        apow.resize(CHUNK + 1);
+        apow[0] = 1.0;
+        for (int k = 1; k <= CHUNK; ++k) apow[k] = apow[k - 1] * (1.0 - KAPPA);
+        if (cfg.rho != 0.0) {
+            std::vector<double> corr(size_t(G) * G, cfg.rho);
+            for (int i = 0; i < G; ++i) corr[size_t(i) * G + i] = 1.0;
+            valid = setCorrelation(std::move(corr), G);
+        }
+    }
+
+    // False when the configured rho gave no usable correlation matrix.
+    bool ok() const { return valid; }
+
+    // Arbitrary correlation matrix (block x block, row-major) applied to every
+    // block of instruments; a shorter last block uses its leading submatrix.
+    bool setCorrelation(std::vector<double> corr, int block) {
+        if (block < 1 || corr.size() != size_t(block) * block || !choleskyFactor(corr, block)) {
+            std::cerr << "Error: correlation matrix is not positive definite\n";
+            return false;
+        }
+        G = std::min(block, n);
+        chol.assign(size_t(G) * G, 0.0);
+        for (int i = 0; i < G; ++i)
+            for (int j = 0; j <= i; ++j) chol[size_t(i) * G + j] = corr[size_t(i) * block + j];
+        return true;
+    }
+
+    // Generator position for block-by-block output: the next round and every
+    // instrument's walk state there (path within the chunk, previous chunk's
+    // end point).
+    struct Cursor {
+        size_t round = 0;
+        std::vector<double> local, carry;
+    };
+    Cursor start() const { return Cursor{0, std::vector<double>(n, 0.0), std::vector<double>(n, 0.0)}; }
+
+    // Ticks [t0, t1) into out[0, t1 - t0).
+    void fill(MarketData* out, size_t t0, size_t t1) const {
+        if (t1 <= t0) return;
+        generate(t0 / n, (t1 + n - 1) / n, nullptr, nullptr, out, t0, t1);
+    }
+
+    // The next `rounds` whole rounds (rounds * n ticks) after `cur` into out;
+    // advances `cur`.
+    void next(Cursor& cur, MarketData* out, size_t rounds) const {
+        if (!rounds) return;
+        const Cursor from = cur;   // tasks read `from` while the last runs write `cur`
+        const size_t r0 = cur.round, r1 = r0 + rounds;
+        generate(r0, r1, &from, &cur, out, r0 * n, r1 * n);
+        cur.round = r1;
+    }
+
+private:
+    CounterFeedConfig cfg;
+    int n, G;
+    std::vector<double> apow;    // (1 - kappa)^k
+    std::vector<double> chol;    // G x G lower factor, empty when uncorrelated
+    bool valid = true;
+
+    static constexpr int TILE_PAIRS = 64;   // Philox blocks per normals batch
+
+    // Normals for rounds [r, r + rounds) and instruments [2*p_lo, 2*p_hi),
+    // tag 0 = shocks, 1 = drift; out[rr * width + (j - 2*p_lo)].
+    void normals(uint32_t tag, size_t r, int rounds, uint32_t p_lo, uint32_t p_hi, double* out) const {
+        alignas(64) uint32_t c0[TILE_PAIRS], c1[TILE_PAIRS], c2[TILE_PAIRS], c3[TILE_PAIRS];
+        const uint32_t P = p_hi - p_lo;
+        size_t done = 0, total = size_t(rounds) * P;
+        while (done < total) {
+            const size_t m = std::min<size_t>(TILE_PAIRS, total - done);
+            for (size_t i = 0; i < m; ++i) {
+                const uint64_t rr = r + (done + i) / P;
+                c0[i] = uint32_t(rr); c1[i] = uint32_t(rr >> 32);
+                c2[i] = p_lo + uint32_t((done + i) % P); c3[i] = tag;
+            }
+            philoxNormals(c0, c1, c2, c3, m, cfg.seed, out + 2 * done);
+            done += m;
+        }
+    }
+
+    // Rounds [r0, r1), emitting ticks [t0, t1) into out[i - t0]. Tasks are
+    // instrument groups x runs of whole chunks. The first run starts from
+    // `from` when given; every other run replays the chunk before it from the
+    // mean to get its carry. The last run of each group leaves its state in `to`.
+    void generate(size_t r0, size_t r1, const Cursor* from, Cursor* to, MarketData* out, size_t t0, size_t t1) const {
+        const size_t c_first = r0 / CHUNK, n_chunks = (r1 - 1) / CHUNK - c_first + 1;
+        const size_t n_groups = (size_t(n) + G - 1) / G;
+        const unsigned T = std::max(1u, cfg.threads);
+        // Aim for ~4 tasks per thread, but keep the warm-up chunks under ~25% of the work.
+        const size_t want = T == 1 ? 1 : (4 * T + n_groups - 1) / n_groups;
+        const size_t runs = std::max<size_t>(1, std::min(want, n_chunks / 4));
+        const size_t n_tasks = n_groups * runs;
+        std::atomic<size_t> next_task{0};
+        auto worker = [&] {
+            for (size_t task; (task = next_task.fetch_add(1, std::memory_order_relaxed)) < n_tasks;) {
+                const size_t g = task % n_groups, run = task / n_groups;
+                const int j0 = int(g * G), j1 = int(std::min<size_t>(n, (g + 1) * G));
+                const size_t rb = run ? (c_first + n_chunks * run / runs) * CHUNK : r0;
+                const size_t re = run + 1 < runs ? (c_first + n_chunks * (run + 1) / runs) * CHUNK : r1;
+                std::vector<double> local(j1 - j0, 0.0), carry(j1 - j0, 0.0);
+                size_t r = rb;
+                if (run == 0 && from) {
+                    std::copy(from->local.begin() + j0, from->local.begin() + j1, local.begin());
+                    std::copy(from->carry.begin() + j0, from->carry.begin() + j1, carry.begin());
+                } else {
+                    const size_t c = rb / CHUNK;
+                    r = c ? (c - 1) * CHUNK : 0;   // warm-up: the chunk before rb's chunk, from the mean
+                }
+                walk(j0, j1, r, re, rb, local.data(), carry.data(), out, t0, t1);
+                if (to && run + 1 == runs) {
+                    std::copy(local.begin(), local.end(), to->local.begin() + j0);
+                    std::copy(carry.begin(), carry.end(), to->carry.begin() + j0);
+                }
+            }
+        };
+        if (T == 1 || n_tasks == 1) worker();
+        else {
+            std::vector<std::thread> pool;
+            for (unsigned w = 0; w < std::min<size_t>(T, n_tasks); ++w) pool.emplace_back(worker);
+            for (auto& t : pool) t.join();
+        }
+    }
+
+    // Steps instruments [j0, j1) through rounds [r, re) from the given state;
+    // ticks of rounds >= emit_from that fall in [t0, t1) are written out.
+    void walk(int j0, int j1, size_t r, size_t re, size_t emit_from, double* local, double* carry,
+              MarketData* out, size_t t0, size_t t1) const {
+        const int g = j1 - j0;
+        const uint32_t p_lo = uint32_t(j0) / 2, p_hi = (uint32_t(j1) + 1) / 2;
+        const int width = int(2 * (p_hi - p_lo)), off = j0 - int(2 * p_lo);
+        const int RB = std::max(1, 2 * TILE_PAIRS / width);     // rounds per normals batch
+        std::vector<double> z(size_t(RB) * width), w(size_t(RB) * width), eps(g);
+
+        for (; r < re; r += RB) {
+            const int rb = int(std::min<size_t>(RB, re - r));
+            normals(0, r, rb, p_lo, p_hi, z.data());
+            normals(1, r, rb, p_lo, p_hi, w.data());
+            for (int rr = 0; rr < rb; ++rr) {
+                const size_t round = r + rr;
+                if (round % CHUNK == 0 && round) {   // new chunk: restart from the mean
+                    std::copy(local, local + g, carry);
+                    std::fill(local, local + g, 0.0);
+                }
+                const double* zr = &z[size_t(rr) * width + off];
+                const double* wr = &w[size_t(rr) * width + off];
+                if (chol.empty()) {
+                    for (int j = 0; j < g; ++j) eps[j] = zr[j];
+                } else {
+                    for (int j = 0; j < g; ++j) {
+                        const double* L = &chol[size_t(j) * G];
+                        double s = 0.0;
+                        for (int m = 0; m <= j; ++m) s += L[m] * zr[m];
+                        eps[j] = s;
+                    }
+                }
+                for (int j = 0; j < g; ++j)
+                    local[j] = (1.0 - KAPPA) * local[j] + KAPPA * DRIFT_SD * wr[j] + SHOCK_SD * eps[j];
+                if (round < emit_from) continue;
+                const size_t k = round % CHUNK + 1, base = round * size_t(n) + j0;
+                if (base + g <= t0 || base >= t1) continue;
+                const auto ts = Clock::now();
+                for (int j = 0; j < g; ++j) {
+                    const size_t i = base + j;
+                    if (i < t0 || i >= t1) continue;
+                    MarketData& md = out[i - t0];
+                    md.instrument_id = j0 + j;
+                    md.price = std::clamp(MEAN + local[j] + apow[k] * carry[j], 50.0, 500.0);
+                    md.timestamp = ts;
+                }
+            }
+        }
+    }
+};
+
 class MarketDataFeed {
 public:
     MarketDataFeed(std::vector<MarketData>& ref, int n_instruments = 10)
         : data(ref), num_instruments(n_instruments) {}
 
+    // Switch to the counter-based generator; the default stays the serial
+    // mt19937_64 stream below.
+    // Returns false (and keeps the current generator) if the config is unusable.
+    bool useCounterRng(const CounterFeedConfig& c) {
+        auto feed = std::make_shared<CounterFeed>(num_instruments, c);
+        if (!feed->ok()) return false;
+        counter = std::move(feed);
+        return true;
+    }
+    bool counterRng() const { return bool(counter); }
+
     void generateData(int num_ticks) {
+        data.clear();
+        if (counter) {
+            data.resize(num_ticks);
+            counter->fill(data.data(), 0, size_t(num_ticks));
+            return;
+        }
+        data.reserve(num_ticks);
+        generate(num_ticks, [&](const MarketData& md) { data.emplace_back(md); });
+    }
+
+    // Columnar variant of generateData; identical ticks, SoA layout.
+    void generateData(int num_ticks, MarketDataColumns& cols) {
+        cols.clear();
+        cols.reserve(num_ticks);
+        generate(num_ticks, [&](const MarketData& md) { cols.push(md); });
+    }
+
+    // Same path as generateData, but each tick is handed to `sink` as soon as
+    // it is stamped (streaming mode publishes it straight into a ring).
+    template<class Sink>
+    void generate(int num_ticks, Sink&& sink) {
+        if (counter) {
+            // Parallel fill of ~256K ticks of whole rounds at a time, then hand the
+            // ticks over in order. The cursor carries the walk from block to block.
+            constexpr size_t BLOCK = size_t(1) << 18;
+            const size_t total = size_t(std::max(num_ticks, 0)), per_round = size_t(std::max(num_instruments, 1));
+            const size_t rounds = std::max<size_t>(1, BLOCK / per_round);
+            std::vector<MarketData> buf(std::min(rounds, (total + per_round - 1) / per_round) * per_round);
+            CounterFeed::Cursor cur = counter->start();
+            for (size_t t = 0; t < total; t += rounds * per_round) {
+                const size_t rb = std::min(rounds, (total - t + per_round - 1) / per_round);
+                counter->next(cur, buf.data(), rb);
+                const size_t m = std::min(rb * per_round, total - t);
+                for (size_t i = 0; i < m; ++i) sink(buf[i]);
+            }
+            return;
+        }
         std::mt19937_64 gen(0xC0FFEE);
         // Price paths per instrument use a mild mean-reverting random walk
         std::vector<double> px(num_instruments, 150.0);
         std::normal_distribution<double> shock(0.0, 0.5); // ~50 bps noise
         std::normal_distribution<double> drift(0.0, 0.02);
 
-        data.clear();
-        data.reserve(num_ticks);
         for (int i = 0; i < num_ticks; ++i) {
             int id = i % num_instruments;
             // OU-style update toward 150 with small noise
@@ -48,13 +502,239 @@ public:
             md.instrument_id = id;
             md.price = std::clamp(px[id], 50.0, 500.0);
             md.timestamp = Clock::now();
-            data.emplace_back(md);
+            sink(md);
         }
     }
 
 private:
     std::vector<MarketData>& data;
     int num_instruments;
+    std::shared_ptr<CounterFeed> counter;
+};
+
+// --------------------------- Binary Tick Files ---------------------------
+// Layout: one 32-byte TickFileHeader followed by `count` fixed-width
+// TickRecords (24 bytes, naturally aligned), native byte order.
+struct TickFileHeader {
+    char magic[8];            // "HFTTICK1"
+    uint32_t version;
+    uint32_t record_size;     // sizeof(TickRecord)
+    uint64_t count;
+    uint32_t num_instruments;
+    uint32_t reserved;
+};
+struct TickRecord {
+    int64_t timestamp_ns;     // capture time (Clock epoch)
+    double price;
+    int32_t instrument_id;
+    uint32_t reserved;
+};
+static_assert(sizeof(TickFileHeader) == 32 && sizeof(TickRecord) == 24, "tick file layout");
+constexpr char TICK_FILE_MAGIC[8] = {'H','F','T','T','I','C','K','1'};
+
+// Streams ticks to disk through a large stdio buffer; the record count in
+// the header is patched on close(), so nothing is held in memory.
+class TickFileWriter {
+public:
+    bool open(const std::string& path, int n_instruments) {
+        f = std::fopen(path.c_str(), "wb");
+        if (!f) { cerr << "Error: cannot create tick file " << path << "\n"; return false; }
+        std::setvbuf(f, nullptr, _IOFBF, 1 << 20);
+        std::memcpy(hdr.magic, TICK_FILE_MAGIC, sizeof(hdr.magic));
+        hdr.version = 1;
+        hdr.record_size = sizeof(TickRecord);
+        hdr.count = 0;
+        hdr.num_instruments = uint32_t(n_instruments);
+        hdr.reserved = 0;
+        return std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    }
+
+    inline void write(const MarketData& md) {
+        TickRecord r{toNanos(md.timestamp), md.price, md.instrument_id, 0};
+        std::fwrite(&r, sizeof(r), 1, f);
+        hdr.count++;
+    }
+
+    bool close() {
+        if (!f) return false;
+        bool ok = std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+        ok = (std::fclose(f) == 0) && ok;
+        f = nullptr;
+        return ok;
+    }
+
+    ~TickFileWriter() { if (f) close(); }
+
+private:
+    std::FILE* f = nullptr;
+    TickFileHeader hdr{};
+};
+
+// Read-only mmap of a tick file; the engine reads records in place. Each
+// tick is stamped with the replay clock when it is read, so tick-to-trade
+// latency refers to this run, not the capture session. Consumed pages can
+// be dropped with releaseBefore() to keep RSS flat on long replays.
+class MappedTickFile {
+public:
+    MappedTickFile() = default;
+    MappedTickFile(const MappedTickFile&) = delete;
+    MappedTickFile& operator=(const MappedTickFile&) = delete;
+    ~MappedTickFile() { unmap(); }
+
+    bool open(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { cerr << "Error: cannot open tick file " << path << "\n"; return false; }
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(TickFileHeader)) {
+            cerr << "Error: " << path << " is not a tick file\n";
+            ::close(fd);
+            return false;
+        }
+        map_len = size_t(st.st_size);
+        void* p = mmap(nullptr, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) { cerr << "Error: mmap failed for " << path << "\n"; map_len = 0; return false; }
+        base = static_cast<const char*>(p);
+        madvise(const_cast<char*>(base), map_len, MADV_SEQUENTIAL);
+
+        std::memcpy(&hdr, base, sizeof(hdr));
+        if (std::memcmp(hdr.magic, TICK_FILE_MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != 1
+            || hdr.record_size != sizeof(TickRecord)
+            || map_len < sizeof(hdr) + hdr.count * sizeof(TickRecord)) {
+            cerr << "Error: " << path << " has a bad header or is truncated\n";
+            unmap();
+            return false;
+        }
+        recs = reinterpret_cast<const TickRecord*>(base + sizeof(hdr));
+        return true;
+#else
+        cerr << "Error: tick file replay needs mmap (POSIX)\n";
+        (void)path;
+        return false;
+#endif
+    }
+
+    size_t size() const { return size_t(hdr.count); }
+    int numInstruments() const { return int(hdr.num_instruments); }
+    inline int idAt(size_t i) const { return recs[i].instrument_id; }
+    const TickRecord& record(size_t i) const { return recs[i]; }
+
+    inline MarketData operator[](size_t i) const {
+        MarketData md;
+        md.instrument_id = recs[i].instrument_id;
+        md.price = recs[i].price;
+        md.timestamp = Clock::now();
+        return md;
+    }
+
+    // Drop the pages holding records [0, i); they are file-backed, so this
+    // only releases memory and a later read would fault them back in.
+    void releaseBefore(size_t i) {
+#if defined(__unix__) || defined(__APPLE__)
+        const size_t page = size_t(sysconf(_SC_PAGESIZE));
+        size_t end = (sizeof(hdr) + i * sizeof(TickRecord)) / page * page;
+        if (end > released) {
+            madvise(const_cast<char*>(base) + released, end - released, MADV_DONTNEED);
+            released = end;
+        }
+#else
+        (void)i;
+#endif
+    }
+
+private:
+    const char* base = nullptr;
+    size_t map_len = 0;
+    size_t released = 0;
+    TickFileHeader hdr{};
+    const TickRecord* recs = nullptr;
+
+    void unmap() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (base) munmap(const_cast<char*>(base), map_len);
+#endif
+        base = nullptr;
+        map_len = 0;
+    }
+};
+
+// Peak resident set size of this process, in KB.
+inline long peakRssKB() {
+    struct rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return long(ru.ru_maxrss / 1024); // bytes on macOS
+#else
+    return long(ru.ru_maxrss);        // KB on Linux
+#endif
+}
+
+// --------------------------- SPSC Ring ---------------------------
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Spin briefly, then start yielding so an oversubscribed box (fewer cores
+// than pipeline threads) still makes progress.
+inline void backoff(unsigned& spins) {
+    if (++spins < 64) cpuRelax();
+    else std::this_thread::yield();
+}
+
+// Bounded lock-free single-producer/single-consumer queue. Head and tail
+// live on their own cache lines, and each side keeps a cached copy of the
+// other's index so the shared line is only re-read when the ring looks
+// full (producer) or empty (consumer).
+template<class T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity_pow2)
+        : mask(capacity_pow2 - 1), buf(capacity_pow2) {}
+
+    size_t capacity() const { return mask + 1; }
+
+    inline bool tryPush(const T& v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail_cache > mask) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h - tail_cache > mask) return false;
+        }
+        buf[h & mask] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    inline bool tryPop(T& out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head_cache) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t == head_cache) return false;
+        }
+        out = buf[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    const size_t mask;
+    std::vector<T> buf;
+    alignas(64) std::atomic<size_t> head{0}; // written by producer
+    size_t tail_cache = 0;                    // producer's view of tail
+    alignas(64) std::atomic<size_t> tail{0}; // written by consumer
+    size_t head_cache = 0;                    // consumer's view of head
+};
+
+// Producer-side backpressure counters for the streaming pipeline.
+struct RingStats {
+    size_t published = 0;
+    size_t full_events = 0;   // pushes that found the ring full at least once
+    size_t full_spins = 0;    // total failed push attempts
+    long long stall_ns = 0;   // time the producer spent blocked on a full ring
 };
 
 // --------------------------- Orders ---------------------------
@@ -66,6 +746,211 @@ struct alignas(64) Order {
     Clock::time_point timestamp; // send time
 };
 
+// Columnar order log, same idea as MarketDataColumns.
+struct OrderColumns {
+    bool fixed_point = false;
+    std::vector<int32_t> instrument_id;
+    std::vector<double> price;      // !fixed_point
+    std::vector<int64_t> price_fp;  // fixed_point
+    std::vector<uint8_t> is_buy;
+    std::vector<uint32_t> signal_mask;
+    std::vector<int64_t> timestamp_ns;
+
+    explicit OrderColumns(bool fixed = false) : fixed_point(fixed) {}
+
+    size_t size() const { return instrument_id.size(); }
+
+    void reserve(size_t n) {
+        instrument_id.reserve(n);
+        (fixed_point ? void(price_fp.reserve(n)) : void(price.reserve(n)));
+        is_buy.reserve(n); signal_mask.reserve(n); timestamp_ns.reserve(n);
+    }
+
+    inline void push(const Order& o) {
+        instrument_id.push_back(o.instrument_id);
+        if (fixed_point) price_fp.push_back(toFixed(o.price));
+        else price.push_back(o.price);
+        is_buy.push_back(o.is_buy);
+        signal_mask.push_back(o.signal_mask);
+        timestamp_ns.push_back(toNanos(o.timestamp));
+    }
+
+    // Copy row k of `src` verbatim (no fixed-point round trip).
+    inline void append(const OrderColumns& src, size_t k) {
+        instrument_id.push_back(src.instrument_id[k]);
+        if (fixed_point) price_fp.push_back(src.price_fp[k]);
+        else price.push_back(src.price[k]);
+        is_buy.push_back(src.is_buy[k]);
+        signal_mask.push_back(src.signal_mask[k]);
+        timestamp_ns.push_back(src.timestamp_ns[k]);
+    }
+
+    inline Order operator[](size_t i) const {
+        return Order{instrument_id[i], fixed_point ? fromFixed(price_fp[i]) : price[i],
+                     is_buy[i] != 0, signal_mask[i], fromNanos(timestamp_ns[i])};
+    }
+};
+
+constexpr const char* ORDERS_CSV_HEADER = "instrument_id,price,is_buy,signal_mask,send_time_ns\n";
+constexpr size_t ORDER_CSV_MAX_LEN = 96; // generous upper bound for one row
+
+// Format one CSV row into `out` (at least ORDER_CSV_MAX_LEN bytes) and return
+// the end pointer. std::to_chars prints the price exactly like
+// `std::fixed << std::setprecision(5)`, without locale or stream state.
+inline char* formatOrderCSV(char* out, const Order& o) {
+    char* end = out + ORDER_CSV_MAX_LEN;
+    out = std::to_chars(out, end, o.instrument_id).ptr;
+    *out++ = ',';
+    out = std::to_chars(out, end, o.price, std::chars_format::fixed, 5).ptr;
+    *out++ = ',';
+    *out++ = o.is_buy ? '1' : '0';
+    *out++ = ',';
+    out = std::to_chars(out, end, o.signal_mask).ptr;
+    *out++ = ',';
+    out = std::to_chars(out, end, toNanos(o.timestamp)).ptr;
+    *out++ = '\n';
+    return out;
+}
+
+// CSV writer shared by both order stores (vector<Order> and OrderColumns).
+template<class OrderStore>
+void writeOrdersCSV(const OrderStore& store, const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return;
+    std::vector<char> buf(1 << 20);
+    size_t len = 0;
+    std::fputs(ORDERS_CSV_HEADER, f);
+    for (size_t i = 0; i < store.size(); ++i) {
+        if (buf.size() - len < ORDER_CSV_MAX_LEN) { std::fwrite(buf.data(), 1, len, f); len = 0; }
+        len = size_t(formatOrderCSV(buf.data() + len, store[i]) - buf.data());
+    }
+    std::fwrite(buf.data(), 1, len, f);
+    std::fclose(f);
+}
+
+// Binary order journal: 16-byte header ("HFTORD01", record size, reserved)
+// followed by fixed 32-byte records.
+struct OrderRecord {
+    double price;
+    int64_t timestamp_ns;
+    int32_t instrument_id;
+    uint32_t signal_mask;
+    uint8_t is_buy;
+    uint8_t reserved[7];
+};
+static_assert(sizeof(OrderRecord) == 32, "order journal layout");
+
+// Background order writer. Each producer (engine shard) gets its own SPSC
+// ring; one journal thread drains them, formats CSV rows (or binary
+// records) into a page-aligned staging buffer and writes it out in whole
+// BLOCK-sized chunks. The engine only ever touches its ring, so the hot loop
+// never waits on the file system; if a ring fills up it spins and the
+// stall is counted. With several producers, rows from different shards
+// interleave in arrival order.
+class OrderJournal {
+public:
+    enum class Format { CSV, Binary };
+    static constexpr size_t BLOCK = size_t(1) << 18;
+
+    OrderJournal(const std::string& path, Format fmt, int n_producers = 1, size_t ring_capacity = 1 << 14)
+        : format(fmt) {
+        for (int i = 0; i < n_producers; ++i)
+            rings.push_back(std::make_unique<SpscRing<Order>>(ring_capacity));
+        f = std::fopen(path.c_str(), "wb");
+        if (!f) { cerr << "Error: cannot create order journal " << path << "\n"; return; }
+        std::setvbuf(f, nullptr, _IONBF, 0); // we already batch
+        stage = static_cast<char*>(std::aligned_alloc(4096, BLOCK + 4096));
+        if (format == Format::CSV) {
+            len = std::strlen(ORDERS_CSV_HEADER);
+            std::memcpy(stage, ORDERS_CSV_HEADER, len);
+        } else {
+            char hdr[16] = {'H','F','T','O','R','D','0','1'};
+            uint32_t rs = sizeof(OrderRecord);
+            std::memcpy(hdr + 8, &rs, sizeof(rs));
+            std::memcpy(stage, hdr, sizeof(hdr));
+            len = sizeof(hdr);
+        }
+        writer = std::thread([this] { run(); });
+    }
+
+    OrderJournal(const OrderJournal&) = delete;
+    OrderJournal& operator=(const OrderJournal&) = delete;
+    ~OrderJournal() { close(); }
+
+    bool ok() const { return f != nullptr; }
+    int producers() const { return int(rings.size()); }
+
+    // Called from the engine thread that owns ring `producer`.
+    inline void push(int producer, const Order& o) {
+        SpscRing<Order>& r = *rings[producer];
+        if (r.tryPush(o)) return;
+        full_events.fetch_add(1, std::memory_order_relaxed);
+        unsigned spins = 0;
+        do backoff(spins); while (!r.tryPush(o));
+    }
+
+    // Drain everything, write the tail and join the writer thread.
+    void close() {
+        if (!writer.joinable()) return;
+        done.store(true, std::memory_order_release);
+        writer.join();
+        if (len) std::fwrite(stage, 1, len, f);
+        bytes_written += len;
+        len = 0;
+        std::fclose(f);
+        f = nullptr;
+        std::free(stage);
+        stage = nullptr;
+    }
+
+    size_t ordersWritten() const { return orders_written; }
+    size_t bytesWritten() const { return bytes_written; }
+    size_t fullEvents() const { return full_events.load(std::memory_order_relaxed); }
+
+private:
+    Format format;
+    std::vector<std::unique_ptr<SpscRing<Order>>> rings;
+    std::FILE* f = nullptr;
+    char* stage = nullptr;
+    size_t len = 0;
+    size_t orders_written = 0, bytes_written = 0;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> full_events{0};
+    std::thread writer;
+
+    void run() {
+        Order o;
+        unsigned spins = 0;
+        for (;;) {
+            bool finishing = done.load(std::memory_order_acquire);
+            bool any = false;
+            for (auto& r : rings)
+                for (int burst = 0; burst < 256 && r->tryPop(o); ++burst) { append(o); any = true; }
+            if (any) spins = 0;
+            else if (finishing) break; // producers stopped before done was set
+            else backoff(spins);
+        }
+    }
+
+    inline void append(const Order& o) {
+        if (format == Format::CSV) {
+            len = size_t(formatOrderCSV(stage + len, o) - stage);
+        } else {
+            OrderRecord r{o.price, toNanos(o.timestamp), o.instrument_id, o.signal_mask,
+                          uint8_t(o.is_buy), {}};
+            std::memcpy(stage + len, &r, sizeof(r));
+            len += sizeof(r);
+        }
+        orders_written++;
+        if (len >= BLOCK) {
+            std::fwrite(stage, 1, BLOCK, f);
+            bytes_written += BLOCK;
+            len -= BLOCK;
+            std::memmove(stage, stage + BLOCK, len);
+        }
+    }
+};
+
 // --------------------------- Utilities ---------------------------
 template<size_t CAP>
 struct PriceHistory {
@@ -126,173 +1011,2136 @@ struct PriceHistory {
     }
 };
 
-// --------------------------- Trading Engine ---------------------------
-class TradeEngine {
+// Rolling statistics over several trailing windows at once (e.g. 8/32/256/1024
+// ticks): mean, stddev, min, max, EMA and VWAP per window, O(1) amortized per
+// add(). Sums are kept relative to a per-window anchor price and recomputed
+// exactly from the ring every W updates. Without that, sumsq/n - m*m
+// cancels catastrophically around a ~150 price, and incremental subtraction
+// drifts. Min/max come from monotonic deques. The hot per-window scalars
+// share one 64-byte line; the price/qty ring and deque slots sit behind them.
+template<size_t... W>
+class RollingStats {
 public:
-    explicit TradeEngine(const std::vector<MarketData>& feed, int n_instruments = 10)
-        : market_data(feed),
-          price_hist(n_instruments),
-          per_signal_counts{0,0,0,0} {
-        orders.reserve(feed.size() / 10); // heuristic
-        latencies.reserve(feed.size() / 5);
-    }
+    static constexpr size_t NW = sizeof...(W);
+    static constexpr array<size_t, NW> windows{W...};
+    static constexpr size_t MAXW = std::max({W...});
+    static_assert(NW >= 1 && ((W >= 1) && ...), "need at least one non-empty window");
 
-    void process() {
-        for (const auto& tick : market_data) {
-            auto& hist = price_hist[tick.instrument_id];
-            hist.add(tick.price);
+    RollingStats() : px(RING), qty(RING), dq(DQ_BASE[NW]) {}
 
-            // signals -> accumulate buy/sell "votes"
-            int buy_votes = 0, sell_votes = 0;
-            uint32_t mask = 0;
+    // qty is the traded size for VWAP; feeds without sizes use 1 (VWAP == SMA).
+    inline void add(double price, double q = 1.0) {
+        const uint64_t t = n_total;
+        for (size_t w = 0; w < NW; ++w) {
+            Window& s = st[w];
+            const size_t Wn = windows[w];
+            if (t >= Wn) { // evict the sample leaving this window (read before the ring slot is reused)
+                const double op = px[(t - Wn) & (RING - 1)], oq = qty[(t - Wn) & (RING - 1)];
+                s.sum_d -= op - s.anchor;
+                s.sumsq_d -= (op - s.anchor) * (op - s.anchor);
+                s.sum_dq -= (op - s.anchor) * oq;
+                s.sum_q -= oq;
+            }
+        }
+        px[t & (RING - 1)] = price;
+        qty[t & (RING - 1)] = q;
+        n_total = t + 1;
+        for (size_t w = 0; w < NW; ++w) {
+            Window& s = st[w];
+            const size_t Wn = windows[w];
+            if (t == 0) { s.anchor = price; s.ema = price; }
+            const double d = price - s.anchor;
+            s.sum_d += d;
+            s.sumsq_d += d * d;
+            s.sum_dq += d * q;
+            s.sum_q += q;
+            s.ema += (2.0 / double(Wn + 1)) * (price - s.ema);
+            pushDeque(s, w, t, price);
+            if ((n_total & (dequeCap(Wn) - 1)) == 0) reanchor(s, Wn); // every pow2(W) >= W adds
+        }
+    }
 
-            // Signal 1: Absolute thresholds (buy low, sell high)
-            if (signal1(tick, buy_votes, sell_votes)) mask |= (1u << 0);
+    uint64_t samples() const { return n_total; }
+    size_t count(size_t w) const { return size_t(std::min<uint64_t>(n_total, windows[w])); }
 
-            // Signal 2: Deviation from rolling average (mean reversion)
-            if (signal2(tick, buy_votes, sell_votes, hist)) mask |= (1u << 1);
+    double mean(size_t w) const {
+        size_t n = count(w);
+        return n ? st[w].anchor + st[w].sum_d / double(n) : 0.0;
+    }
+    double variance(size_t w) const { // population variance, like PriceHistory
+        size_t n = count(w);
+        if (n < 2) return 0.0;
+        double m = st[w].sum_d / double(n);
+        double var = st[w].sumsq_d / double(n) - m * m;
+        return var > 0 ? var : 0.0;
+    }
+    double stddev(size_t w) const { return std::sqrt(variance(w)); }
+    double ema(size_t w) const { return st[w].ema; }
+    double vwap(size_t w) const {
+        return st[w].sum_q > 0 ? st[w].anchor + st[w].sum_dq / st[w].sum_q : 0.0;
+    }
+    double min(size_t w) const { return n_total ? px[dq[minSlot(w, st[w].min_head)] & (RING - 1)] : 0.0; }
+    double max(size_t w) const { return n_total ? px[dq[maxSlot(w, st[w].max_head)] & (RING - 1)] : 0.0; }
 
-            // Signal 3: Simple momentum (2 consecutive moves)
-            if (signal3(tick, buy_votes, sell_votes, hist)) mask |= (1u << 2);
+private:
+    static constexpr size_t pow2(size_t x) { size_t p = 1; while (p < x) p <<= 1; return p; }
+    static constexpr size_t RING = pow2(MAXW);
+    static constexpr size_t dequeCap(size_t w) { return pow2(w); }
+    // Offset of window w's deques in dq: min deque, then max deque.
+    static constexpr array<size_t, NW + 1> DQ_BASE = [] {
+        array<size_t, NW + 1> b{};
+        for (size_t w = 0; w < NW; ++w) b[w + 1] = b[w] + 2 * dequeCap(windows[w]);
+        return b;
+    }();
 
-#if ENABLE_VOL_SIGNAL
-            // Bonus Signal 4: Volatility breakout
-            if (signal4_vol_breakout(tick, buy_votes, sell_votes, hist)) mask |= (1u << 3);
-#endif
+    struct alignas(64) Window {
+        double anchor = 0.0;
+        double sum_d = 0.0, sumsq_d = 0.0; // sums of (p - anchor), (p - anchor)^2
+        double sum_dq = 0.0, sum_q = 0.0;  // sum of (p - anchor) * q, sum of q
+        double ema = 0.0;
+        uint32_t min_head = 0, min_tail = 0, max_head = 0, max_tail = 0;
+    };
+    static_assert(sizeof(Window) == 64, "one cache line per window");
 
-            if (buy_votes || sell_votes) {
-                bool is_buy = (buy_votes > sell_votes) || (buy_votes == sell_votes && (tick.instrument_id & 1));
-                auto now = Clock::now();
-                double px = tick.price + (is_buy ? 0.01 : -0.01);
-                orders.push_back(Order{tick.instrument_id, px, is_buy, mask, now});
+    array<Window, NW> st{};
+    uint64_t n_total = 0;
+    std::vector<double> px, qty;  // shared ring, RING slots
+    std::vector<uint32_t> dq;     // deque slots hold tick numbers (mod 2^32)
 
-                auto latency = std::chrono::duration_cast<ns>(now - tick.timestamp).count();
-                latencies.push_back(latency);
+    size_t minSlot(size_t w, uint32_t i) const { return DQ_BASE[w] + (i & (dequeCap(windows[w]) - 1)); }
+    size_t maxSlot(size_t w, uint32_t i) const { return minSlot(w, i) + dequeCap(windows[w]); }
+    double pxAt(uint32_t tick) const { return px[tick & (RING - 1)]; }
 
-                // track per-signal contributions (if that bit fired, attribute this order too)
-                for (int s = 0; s < 4; ++s)
-                    if (mask & (1u << s)) per_signal_counts[s]++;
-            }
-        }
+    inline void pushDeque(Window& s, size_t w, uint64_t t, double price) {
+        const uint32_t now = uint32_t(t);
+        const uint32_t Wn = uint32_t(windows[w]);
+        // Expire first so a deque never holds more than W entries (its capacity).
+        // min: values strictly increasing from head to tail
+        if (s.min_tail != s.min_head && now - dq[minSlot(w, s.min_head)] >= Wn) s.min_head++;
+        while (s.min_tail != s.min_head && pxAt(dq[minSlot(w, s.min_tail - 1)]) >= price) s.min_tail--;
+        dq[minSlot(w, s.min_tail++)] = now;
+        // max: strictly decreasing
+        if (s.max_tail != s.max_head && now - dq[maxSlot(w, s.max_head)] >= Wn) s.max_head++;
+        while (s.max_tail != s.max_head && pxAt(dq[maxSlot(w, s.max_tail - 1)]) <= price) s.max_tail--;
+        dq[maxSlot(w, s.max_tail++)] = now;
     }
 
-    void reportStats() const {
-        long long sum = 0, max_latency = 0;
-        for (auto l : latencies) { sum += l; if (l > max_latency) max_latency = l; }
-
-        // p50 / p95 / p99 (optional but handy)
-        vector<long long> sorted = latencies;
-        auto pct = [&](double p)->long long {
-            if (sorted.empty()) return 0;
-            size_t idx = size_t(p * (sorted.size()-1));
-            nth_element(sorted.begin(), sorted.begin()+idx, sorted.end());
-            return sorted[idx];
-        };
-
-        cout << "\n--- Performance Report ---\n";
-        cout << "Total Market Ticks Processed: " << market_data.size() << "\n";
-        cout << "Total Orders Placed: " << orders.size() << "\n";
-        cout << "Average Tick-to-Trade Latency (ns): " << (latencies.empty() ? 0 : sum / (long long)latencies.size()) << "\n";
-        cout << "Max Tick-to-Trade Latency (ns): " << max_latency << "\n";
-        if (!latencies.empty()) {
-            cout << "p50/p95/p99 Latency (ns): " << pct(0.50) << " / " << pct(0.95) << " / " << pct(0.99) << "\n";
+    // Move the anchor to the current mean and rebuild the sums from the ring.
+    void reanchor(Window& s, size_t Wn) {
+        const size_t n = size_t(std::min<uint64_t>(n_total, Wn));
+        const double a = s.anchor + s.sum_d / double(n);
+        double sd = 0.0, ss = 0.0, sdq = 0.0, sq = 0.0;
+        for (uint64_t t = n_total - n; t < n_total; ++t) {
+            const double d = px[t & (RING - 1)] - a, q = qty[t & (RING - 1)];
+            sd += d; ss += d * d; sdq += d * q; sq += q;
         }
-        cout << "\nPer-signal order attributions (orders where the signal fired):\n";
-        cout << "  S1 Threshold     : " << per_signal_counts[0] << "\n";
-        cout << "  S2 MeanRevert    : " << per_signal_counts[1] << "\n";
-        cout << "  S3 Momentum      : " << per_signal_counts[2] << "\n";
-#if ENABLE_VOL_SIGNAL
-        cout << "  S4 VolBreakout   : " << per_signal_counts[3] << "\n";
+        s.anchor = a;
+        s.sum_d = sd; s.sumsq_d = ss; s.sum_dq = sdq; s.sum_q = sq;
+    }
+};
+
+// Best-effort pin of the calling thread to one core. macOS only exposes
+// affinity hints, so there this is a no-op.
+inline void pinThreadToCore(unsigned core) {
+#if defined(__linux__)
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % hw, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)core;
 #endif
+}
+
+// Fixed-memory log-linear latency histogram (HdrHistogram layout). Values
+// below 2^sub_bits get exact buckets; each power-of-two range above that is
+// split into 2^(sub_bits-1) linear buckets, so any reported value is within
+// a relative 2^-(sub_bits-1) of the true one. record() is a clz plus an
+// increment; histograms with the same precision merge by adding counts.
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(int sub_bits = 8, int max_value_bits = 40)
+        : sub_bits(std::clamp(sub_bits, 2, 16)),
+          max_value((max_value_bits >= 63) ? INT64_MAX : (int64_t(1) << max_value_bits) - 1) {
+        counts.assign(bucketOf(max_value) + 1, 0);
     }
 
-    // Bonus: write CSV of orders
-    void exportCSV(const std::string& path = "orders.csv") const {
-        std::ofstream f(path);
-        if (!f) return;
-        f << "instrument_id,price,is_buy,signal_mask,send_time_ns\n";
-        for (const auto& o : orders) {
-            auto t = std::chrono::time_point_cast<ns>(o.timestamp).time_since_epoch().count();
-            f << o.instrument_id << "," << std::fixed << std::setprecision(5) << o.price << ","
-              << (o.is_buy ? 1 : 0) << "," << o.signal_mask << "," << t << "\n";
+    inline void record(int64_t v) {
+        v = std::clamp<int64_t>(v, 0, max_value);
+        counts[bucketOf(v)]++;
+        total++;
+        sum += v;
+        if (v < min_v) min_v = v;
+        if (v > max_v) max_v = v;
+    }
+
+    void merge(const LatencyHistogram& o) {
+        if (o.sub_bits != sub_bits || o.counts.size() != counts.size()) {
+            for (size_t b = 0; b < o.counts.size(); ++b)      // re-bucket
+                for (uint64_t c = 0; c < o.counts[b]; ++c) record(o.valueOf(b));
+            return;
         }
+        for (size_t b = 0; b < counts.size(); ++b) counts[b] += o.counts[b];
+        total += o.total;
+        sum += o.sum;
+        min_v = std::min(min_v, o.min_v);
+        max_v = std::max(max_v, o.max_v);
     }
 
-    // expose counts for the write-up
-    const array<size_t,4>& signalCounts() const { return per_signal_counts; }
+    void reset() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0; sum = 0; min_v = INT64_MAX; max_v = 0;
+    }
 
-private:
-    const std::vector<MarketData>& market_data;
-    std::vector<Order> orders;
-    std::vector<long long> latencies;
-    std::vector<PriceHistory<32>> price_hist; // small, cache-friendly window
-    array<size_t,4> per_signal_counts;
-
-    // --------- Signals ----------
-    // S1: Absolute thresholds (buy low, sell high)
-    inline bool signal1(const MarketData& tick, int& buy, int& sell) const {
-        if (tick.price < 105.0) { buy++; return true; }
-        if (tick.price > 195.0) { sell++; return true; }
-        return false;
+    uint64_t count() const { return total; }
+    int64_t max() const { return total ? max_v : 0; }
+    int64_t min() const { return total ? min_v : 0; }
+    int64_t mean() const { return total ? int64_t(sum / total) : 0; }
+
+    // Smallest recorded-bucket value v such that a fraction >= p of samples are <= v.
+    int64_t percentile(double p) const {
+        if (!total) return 0;
+        uint64_t rank = std::max<uint64_t>(1, uint64_t(std::ceil(p * double(total))));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < counts.size(); ++b) {
+            seen += counts[b];
+            if (seen >= rank) return std::min(valueOf(b), max_v);
+        }
+        return max_v;
     }
 
-    // S2: Deviation from rolling average (mean reversion)
-    inline bool signal2(const MarketData& tick, int& buy, int& sell, const PriceHistory<32>& hist) const {
-        if (hist.size < 5) return false;
-        double avg = hist.avg();
-        if (avg == 0.0) return false;
-        if (tick.price < avg * 0.98) { buy++; return true; }
-        if (tick.price > avg * 1.02) { sell++; return true; }
-        return false;
+    // p50/p90/p99/p99.9/p99.99 on one line.
+    void printPercentiles(std::ostream& os) const {
+        os << percentile(0.50) << " / " << percentile(0.90) << " / " << percentile(0.99)
+           << " / " << percentile(0.999) << " / " << percentile(0.9999);
     }
 
-    // S3: Momentum (two consecutive moves same direction)
-    inline bool signal3(const MarketData& tick, int& buy, int& sell, const PriceHistory<32>& hist) const {
-        double a,b,c;
-        if (!hist.last3(a,b,c)) return false;
-        double d1 = b - a, d2 = c - b;
-        if (d1 > 0 && d2 > 0) { buy++; return true; }
-        if (d1 < 0 && d2 < 0) { sell++; return true; }
-        return false;
+private:
+    int sub_bits;
+    int64_t max_value;
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    unsigned __int128 sum = 0;
+    int64_t min_v = INT64_MAX, max_v = 0;
+
+    inline size_t bucketOf(int64_t v) const {
+        const uint64_t u = uint64_t(v);
+        const uint64_t sub = uint64_t(1) << sub_bits, half = sub >> 1;
+        if (u < sub) return size_t(u);
+        int shift = (63 - __builtin_clzll(u)) - (sub_bits - 1);
+        return size_t(uint64_t(shift) * half + (u >> shift));
     }
 
-#if ENABLE_VOL_SIGNAL
-    // S4 (bonus): Volatility breakout vs recent stdev
-    inline bool signal4_vol_breakout(const MarketData& tick, int& buy, int& sell, const PriceHistory<32>& hist) const {
-        if (hist.size < 12) return false;
-        double sd = hist.stddev();
-        double prev;
-        if (!hist.last(prev)) return false;
-        double chg = tick.price - prev;
-        double k = 1.75; // breakout multiplier
-        if (sd <= 1e-9) return false;
-        if (chg >  k * sd) { buy++; return true; }
-        if (chg < -k * sd) { sell++; return true; }
-        return false;
+    // Highest value that maps to bucket b.
+    inline int64_t valueOf(size_t b) const {
+        const uint64_t sub = uint64_t(1) << sub_bits, half = sub >> 1;
+        if (b < sub) return int64_t(b);
+        uint64_t shift = b / half - 1, m = b - shift * half;
+        return int64_t(((m + 1) << shift) - 1);
     }
-#endif
 };
 
-// --------------------------- Main ---------------------------
-int main() {
-    ios::sync_with_stdio(false);
-    cin.tie(nullptr);
-
+// --------------------------- TSC Instrumentation ---------------------------
+// Raw cycle counter: rdtsc on x86, the virtual counter on AArch64, and
+// steady_clock nanoseconds elsewhere.
+inline uint64_t readTsc() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return uint64_t(std::chrono::duration_cast<ns>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Counter-to-time conversion, calibrated once against steady_clock.
+struct TscClock {
+    static inline double ns_per_tick = 1.0;
+
+    static void calibrate(int ms_window = 50) {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = readTsc();
+        while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(ms_window)) {}
+        uint64_t c1 = readTsc();
+        auto t1 = std::chrono::steady_clock::now();
+        double elapsed = double(std::chrono::duration_cast<ns>(t1 - t0).count());
+        if (c1 > c0) ns_per_tick = elapsed / double(c1 - c0);
+    }
+};
+
+// Stages of the per-tick path. Signal stages are STAGE_SIGNAL + strategy index.
+enum ProfileStage : int {
+    STAGE_HISTORY = 0,      // PriceHistory::add
+    STAGE_SIMD_SIGNALS,     // one batched lane-block evaluation
+    STAGE_ORDER,            // order construction, timestamp and hand-off
+    STAGE_ROLLING,          // multi-window RollingStats update (--rolling)
+    STAGE_SIGNAL,           // first strategy
+    STAGE_COUNT = STAGE_SIGNAL + 32
+};
+
+struct StageProfile {
+    array<uint64_t, STAGE_COUNT> cycles{};
+    array<uint64_t, STAGE_COUNT> calls{};
+
+    void add(const StageProfile& o) {
+        for (int i = 0; i < STAGE_COUNT; ++i) { cycles[i] += o.cycles[i]; calls[i] += o.calls[i]; }
+    }
+};
+
+// Per-thread StageProfile buffers. Each thread accumulates into its own copy
+// without sharing; when the thread exits, the copy is folded into a global total.
+class ProfileRegistry {
+public:
+    static StageProfile& local() { thread_local Local l; return l.p; }
+
+    // Totals from finished threads plus the calling thread's own counters.
+    static StageProfile snapshot() {
+        std::lock_guard<std::mutex> lock(mu());
+        StageProfile out = global();
+        out.add(local());
+        return out;
+    }
+
+private:
+    struct Local {
+        StageProfile p;
+        ~Local() { std::lock_guard<std::mutex> lock(mu()); global().add(p); }
+    };
+    static StageProfile& global() { static StageProfile g; return g; }
+    static std::mutex& mu() { static std::mutex m; return m; }
+};
+
+// RAII cycle timer for one stage.
+struct TscScope {
+    int stage;
+    uint64_t t0;
+    explicit TscScope(int s) : stage(s), t0(readTsc()) {}
+    ~TscScope() {
+        StageProfile& p = ProfileRegistry::local();
+        p.cycles[stage] += readTsc() - t0;
+        p.calls[stage]++;
+    }
+};
+
+#define HFT_PROFILE_CAT2(a, b) a##b
+#define HFT_PROFILE_CAT(a, b) HFT_PROFILE_CAT2(a, b)
+#if ENABLE_TSC_PROFILE
+#define HFT_PROFILE_SCOPE(stage) TscScope HFT_PROFILE_CAT(tsc_scope_, __LINE__)(stage)
+#else
+#define HFT_PROFILE_SCOPE(stage) ((void)0)
+#endif
+
+// --------------------------- Signal Strategies ---------------------------
+// A strategy is a stateless type with
+//   static constexpr const char* name;  // report label
+//   static constexpr size_t window;     // history samples it needs
+//   template<class Hist> static int vote(double price, const Hist& h);
+//                                       // +1 buy, -1 sell, 0 no signal
+// `h` already contains `price` as its newest sample.
+
+// S1: Absolute thresholds (buy low, sell high)
+struct ThresholdSignal {
+    static constexpr const char* name = "S1 Threshold";
+    static constexpr size_t window = 1;
+    template<class Hist>
+    static inline int vote(double price, const Hist&) {
+        if (price < 105.0) return 1;
+        if (price > 195.0) return -1;
+        return 0;
+    }
+};
+
+// S2: Deviation from rolling average (mean reversion)
+struct MeanRevertSignal {
+    static constexpr const char* name = "S2 MeanRevert";
+    static constexpr size_t window = 32;
+    template<class Hist>
+    static inline int vote(double price, const Hist& hist) {
+        if (hist.size < 5) return 0;
+        double avg = hist.avg();
+        if (avg == 0.0) return 0;
+        if (price < avg * 0.98) return 1;
+        if (price > avg * 1.02) return -1;
+        return 0;
+    }
+};
+
+// S3: Momentum (two consecutive moves same direction)
+struct MomentumSignal {
+    static constexpr const char* name = "S3 Momentum";
+    static constexpr size_t window = 3;
+    template<class Hist>
+    static inline int vote(double, const Hist& hist) {
+        double a,b,c;
+        if (!hist.last3(a,b,c)) return 0;
+        double d1 = b - a, d2 = c - b;
+        if (d1 > 0 && d2 > 0) return 1;
+        if (d1 < 0 && d2 < 0) return -1;
+        return 0;
+    }
+};
+
+// S4 (bonus): Volatility breakout vs recent stdev
+struct VolBreakoutSignal {
+    static constexpr const char* name = "S4 VolBreakout";
+    static constexpr size_t window = 32;
+    template<class Hist>
+    static inline int vote(double price, const Hist& hist) {
+        if (hist.size < 12) return 0;
+        double sd = hist.stddev();
+        double prev;
+        if (!hist.last(prev)) return 0;
+        double chg = price - prev;
+        double k = 1.75; // breakout multiplier
+        if (sd <= 1e-9) return 0;
+        if (chg >  k * sd) return 1;
+        if (chg < -k * sd) return -1;
+        return 0;
+    }
+};
+
+// Fixed set of strategies fused into one evaluation. Strategy I owns bit I
+// of the order's signal_mask and slot I of the counters; the shared history
+// is sized to the largest declared window. Everything is resolved at compile
+// time, so the fold below inlines to the same straight-line code as a
+// hand-written sequence of if-statements.
+template<class... S>
+struct SignalPipeline {
+    static constexpr size_t N = sizeof...(S);
+    static_assert(N >= 1 && N <= 32, "signal_mask has 32 bits");
+    static constexpr size_t window = std::max({S::window...});
+    using History = PriceHistory<window>;
+    using Counts = array<size_t, N>;
+    static constexpr array<const char*, N> names{S::name...};
+
+    // Accumulates buy/sell votes and returns the mask of strategies that fired.
+    // Any history at least `window` deep works (see hft_bench's capacity sweep).
+    template<class Hist = History>
+    static inline uint32_t eval(double price, const Hist& hist, int& buy, int& sell) {
+        return evalImpl(price, hist, buy, sell, std::index_sequence_for<S...>{});
+    }
+
+    // Attribute an order to every strategy whose bit is set.
+    static inline void count(uint32_t mask, Counts& counts) {
+        countImpl(mask, counts, std::make_index_sequence<N>{});
+    }
+
+    static void report(std::ostream& os, const Counts& counts) {
+        for (size_t i = 0; i < N; ++i) {
+            std::string label = names[i];
+            if (label.size() < 17) label.resize(17, ' ');
+            os << "  " << label << ": " << counts[i] << "\n";
+        }
+    }
+
+private:
+    template<class Hist, size_t... I>
+    static inline uint32_t evalImpl(double price, const Hist& hist, int& buy, int& sell,
+                                    std::index_sequence<I...>) {
+        uint32_t mask = 0;
+        ((voteOne<S, I>(price, hist, buy, sell, mask)), ...);
+        return mask;
+    }
+
+    template<class Strategy, size_t I, class Hist>
+    static inline void voteOne(double price, const Hist& hist, int& buy, int& sell, uint32_t& mask) {
+        HFT_PROFILE_SCOPE(STAGE_SIGNAL + int(I));
+        int v = Strategy::vote(price, hist);
+        buy += (v > 0);
+        sell += (v < 0);
+        mask |= uint32_t(v != 0) << I;
+    }
+
+    template<size_t... I>
+    static inline void countImpl(uint32_t mask, Counts& counts, std::index_sequence<I...>) {
+        ((counts[I] += (mask >> I) & 1u), ...);
+    }
+};
+
+using BuiltinSignals3 = SignalPipeline<ThresholdSignal, MeanRevertSignal, MomentumSignal>;
+using BuiltinSignals4 = SignalPipeline<ThresholdSignal, MeanRevertSignal, MomentumSignal, VolBreakoutSignal>;
+#if ENABLE_VOL_SIGNAL
+using DefaultSignals = BuiltinSignals4;
+#else
+using DefaultSignals = BuiltinSignals3;
+#endif
+
+// --------------------------- Batched Signals ---------------------------
+// Lane block for batched evaluation of signals 1-4: one lane per tick, every
+// lane a different instrument, rolling state (n, sum, sumsq, last three
+// prices) laid out field by field so one vector register covers 4 (AVX2) or
+// 8 (AVX-512) instruments. The math mirrors the four built-in strategies
+// op for op, so the vote masks are bit-exact with the scalar path.
+struct alignas(64) SignalLanes {
+    static constexpr int W = 8;
+    double price[W], n[W], sum[W], sumsq[W], a[W], b[W], c[W];
+    int id[W];
+    uint64_t seq[W];
+    Clock::time_point ts[W];
+    int count = 0;
+};
+
+// Per-signal buy/sell lane bitmasks (bit k = lane k).
+struct SignalVotes {
+    uint32_t buy[4], sell[4];
+};
+
+#if defined(__AVX512F__)
+inline SignalVotes evalSignalLanes(const SignalLanes& L) {
+    const __m512d px = _mm512_load_pd(L.price), n = _mm512_load_pd(L.n);
+    const __m512d sum = _mm512_load_pd(L.sum), sumsq = _mm512_load_pd(L.sumsq);
+    const __m512d a = _mm512_load_pd(L.a), b = _mm512_load_pd(L.b), c = _mm512_load_pd(L.c);
+    SignalVotes v;
+    // S1: absolute thresholds
+    __mmask8 b1 = _mm512_cmp_pd_mask(px, _mm512_set1_pd(105.0), _CMP_LT_OQ);
+    v.buy[0] = b1;
+    v.sell[0] = _mm512_mask_cmp_pd_mask(__mmask8(~b1), px, _mm512_set1_pd(195.0), _CMP_GT_OQ);
+    // S2: deviation from rolling average
+    __m512d avg = _mm512_div_pd(sum, n);
+    __mmask8 ok2 = _mm512_cmp_pd_mask(n, _mm512_set1_pd(5.0), _CMP_GE_OQ)
+                 & _mm512_cmp_pd_mask(avg, _mm512_setzero_pd(), _CMP_NEQ_UQ);
+    __mmask8 b2 = _mm512_mask_cmp_pd_mask(ok2, px, _mm512_mul_pd(avg, _mm512_set1_pd(0.98)), _CMP_LT_OQ);
+    v.buy[1] = b2;
+    v.sell[1] = _mm512_mask_cmp_pd_mask(ok2 & __mmask8(~b2), px, _mm512_mul_pd(avg, _mm512_set1_pd(1.02)), _CMP_GT_OQ);
+    // S3: two consecutive moves
+    __mmask8 ok3 = _mm512_cmp_pd_mask(n, _mm512_set1_pd(3.0), _CMP_GE_OQ);
+    __m512d d1 = _mm512_sub_pd(b, a), d2 = _mm512_sub_pd(c, b), z = _mm512_setzero_pd();
+    v.buy[2] = ok3 & _mm512_cmp_pd_mask(d1, z, _CMP_GT_OQ) & _mm512_cmp_pd_mask(d2, z, _CMP_GT_OQ);
+    v.sell[2] = ok3 & _mm512_cmp_pd_mask(d1, z, _CMP_LT_OQ) & _mm512_cmp_pd_mask(d2, z, _CMP_LT_OQ);
+    // S4: volatility breakout
+    __m512d var = _mm512_sub_pd(_mm512_div_pd(sumsq, n), _mm512_mul_pd(avg, avg));
+    __mmask8 pos = _mm512_cmp_pd_mask(var, z, _CMP_GT_OQ);
+    __m512d sd = _mm512_maskz_sqrt_pd(pos, var);
+    __mmask8 ok4 = _mm512_cmp_pd_mask(n, _mm512_set1_pd(12.0), _CMP_GE_OQ)
+                 & _mm512_cmp_pd_mask(sd, _mm512_set1_pd(1e-9), _CMP_GT_OQ);
+    __m512d chg = _mm512_sub_pd(px, c);
+    __mmask8 b4 = _mm512_mask_cmp_pd_mask(ok4, chg, _mm512_mul_pd(_mm512_set1_pd(1.75), sd), _CMP_GT_OQ);
+    v.buy[3] = b4;
+    v.sell[3] = _mm512_mask_cmp_pd_mask(ok4 & __mmask8(~b4), chg, _mm512_mul_pd(_mm512_set1_pd(-1.75), sd), _CMP_LT_OQ);
+    return v;
+}
+#elif defined(__AVX2__)
+inline SignalVotes evalSignalLanes(const SignalLanes& L) {
+    SignalVotes v{};
+    const __m256d z = _mm256_setzero_pd();
+    for (int o = 0; o < SignalLanes::W; o += 4) {
+        const __m256d px = _mm256_load_pd(L.price + o), n = _mm256_load_pd(L.n + o);
+        const __m256d sum = _mm256_load_pd(L.sum + o), sumsq = _mm256_load_pd(L.sumsq + o);
+        const __m256d a = _mm256_load_pd(L.a + o), b = _mm256_load_pd(L.b + o), c = _mm256_load_pd(L.c + o);
+        auto bits = [o](__m256d m) { return uint32_t(_mm256_movemask_pd(m)) << o; };
+        // S1: absolute thresholds
+        __m256d b1 = _mm256_cmp_pd(px, _mm256_set1_pd(105.0), _CMP_LT_OQ);
+        __m256d s1 = _mm256_andnot_pd(b1, _mm256_cmp_pd(px, _mm256_set1_pd(195.0), _CMP_GT_OQ));
+        // S2: deviation from rolling average
+        __m256d avg = _mm256_div_pd(sum, n);
+        __m256d ok2 = _mm256_and_pd(_mm256_cmp_pd(n, _mm256_set1_pd(5.0), _CMP_GE_OQ),
+                                    _mm256_cmp_pd(avg, z, _CMP_NEQ_UQ));
+        __m256d b2 = _mm256_and_pd(ok2, _mm256_cmp_pd(px, _mm256_mul_pd(avg, _mm256_set1_pd(0.98)), _CMP_LT_OQ));
+        __m256d s2 = _mm256_andnot_pd(b2, _mm256_and_pd(ok2,
+                         _mm256_cmp_pd(px, _mm256_mul_pd(avg, _mm256_set1_pd(1.02)), _CMP_GT_OQ)));
+        // S3: two consecutive moves
+        __m256d ok3 = _mm256_cmp_pd(n, _mm256_set1_pd(3.0), _CMP_GE_OQ);
+        __m256d d1 = _mm256_sub_pd(b, a), d2 = _mm256_sub_pd(c, b);
+        __m256d b3 = _mm256_and_pd(ok3, _mm256_and_pd(_mm256_cmp_pd(d1, z, _CMP_GT_OQ), _mm256_cmp_pd(d2, z, _CMP_GT_OQ)));
+        __m256d s3 = _mm256_and_pd(ok3, _mm256_and_pd(_mm256_cmp_pd(d1, z, _CMP_LT_OQ), _mm256_cmp_pd(d2, z, _CMP_LT_OQ)));
+        // S4: volatility breakout (sqrt of a non-positive variance is masked to 0)
+        __m256d var = _mm256_sub_pd(_mm256_div_pd(sumsq, n), _mm256_mul_pd(avg, avg));
+        __m256d sd = _mm256_and_pd(_mm256_cmp_pd(var, z, _CMP_GT_OQ), _mm256_sqrt_pd(var));
+        __m256d ok4 = _mm256_and_pd(_mm256_cmp_pd(n, _mm256_set1_pd(12.0), _CMP_GE_OQ),
+                                    _mm256_cmp_pd(sd, _mm256_set1_pd(1e-9), _CMP_GT_OQ));
+        __m256d chg = _mm256_sub_pd(px, c);
+        __m256d b4 = _mm256_and_pd(ok4, _mm256_cmp_pd(chg, _mm256_mul_pd(_mm256_set1_pd(1.75), sd), _CMP_GT_OQ));
+        __m256d s4 = _mm256_andnot_pd(b4, _mm256_and_pd(ok4,
+                         _mm256_cmp_pd(chg, _mm256_mul_pd(_mm256_set1_pd(-1.75), sd), _CMP_LT_OQ)));
+        v.buy[0] |= bits(b1); v.sell[0] |= bits(s1);
+        v.buy[1] |= bits(b2); v.sell[1] |= bits(s2);
+        v.buy[2] |= bits(b3); v.sell[2] |= bits(s3);
+        v.buy[3] |= bits(b4); v.sell[3] |= bits(s4);
+    }
+    return v;
+}
+#else
+// Portable fallback: same comparisons, combined with bit ops rather than
+// branches so the compiler can still if-convert / auto-vectorize it.
+inline SignalVotes evalSignalLanes(const SignalLanes& L) {
+    SignalVotes v{};
+    for (int k = 0; k < SignalLanes::W; ++k) {
+        const double px = L.price[k], n = L.n[k];
+        uint32_t b1 = px < 105.0, s1 = !b1 & (px > 195.0);
+        double avg = L.sum[k] / n;
+        uint32_t ok2 = (n >= 5.0) & (avg != 0.0);
+        uint32_t b2 = ok2 & (px < avg * 0.98), s2 = ok2 & !b2 & (px > avg * 1.02);
+        double d1 = L.b[k] - L.a[k], d2 = L.c[k] - L.b[k];
+        uint32_t ok3 = n >= 3.0;
+        uint32_t b3 = ok3 & (d1 > 0) & (d2 > 0), s3 = ok3 & (d1 < 0) & (d2 < 0);
+        double var = L.sumsq[k] / n - avg * avg;
+        double sd = var > 0 ? std::sqrt(var) : 0.0;
+        double chg = px - L.c[k];
+        uint32_t ok4 = (n >= 12.0) & (sd > 1e-9);
+        uint32_t b4 = ok4 & (chg > 1.75 * sd), s4 = ok4 & !b4 & (chg < -1.75 * sd);
+        v.buy[0] |= b1 << k; v.sell[0] |= s1 << k;
+        v.buy[1] |= b2 << k; v.sell[1] |= s2 << k;
+        v.buy[2] |= b3 << k; v.sell[2] |= s3 << k;
+        v.buy[3] |= b4 << k; v.sell[3] |= s4 << k;
+    }
+    return v;
+}
+#endif
+
+// --------------------------- Trading Engine ---------------------------
+// Pipeline is a SignalPipeline<...>; TradeEngine runs DefaultSignals.
+template<class Pipeline = DefaultSignals>
+class TradeEngineT {
+public:
+    using History = typename Pipeline::History;
+    using Counts = typename Pipeline::Counts;
+    // The SIMD lane evaluator hard-codes the built-in strategies.
+    static constexpr bool SIMD_CAPABLE = std::is_same_v<Pipeline, BuiltinSignals4>
+                                      || std::is_same_v<Pipeline, BuiltinSignals3>;
+
+    // n_threads > 1 selects the sharded mode: instruments are split into
+    // contiguous ranges, one per worker thread pinned to its own core.
+    explicit TradeEngineT(const std::vector<MarketData>& feed, int n_instruments = 10, int n_threads = 1)
+        : rows(&feed), per_signal_counts{} {
+        init(feed.size(), n_instruments, n_threads);
+    }
+
+    // Same engine over a columnar feed.
+    explicit TradeEngineT(const MarketDataColumns& feed, int n_instruments = 10, int n_threads = 1)
+        : cols(&feed), per_signal_counts{} {
+        init(feed.size(), n_instruments, n_threads);
+    }
+
+    // Zero-copy replay straight from a mapped tick file.
+    explicit TradeEngineT(MappedTickFile& feed, int n_instruments = 10, int n_threads = 1)
+        : mapped(&feed), per_signal_counts{} {
+        init(feed.size(), n_instruments, n_threads);
+    }
+
+    // Per-instrument multi-window statistics kept alongside the signal history.
+    using InstrumentStats = RollingStats<8, 32, 256, 1024>;
+
+    // Maintain InstrumentStats for every instrument (call before process()).
+    void setRollingStats(bool on) {
+        for (auto& sh : shards) {
+            sh.rolling.clear();
+            if (on) sh.rolling.resize(sh.price_hist.size());
+        }
+    }
+
+    // Evaluate signals in SIMD lane blocks instead of one tick at a time.
+    // Only the built-in strategy sets have a lane evaluator; others ignore it.
+    void setBatchedSignals(bool on) { batched = on && SIMD_CAPABLE; }
+
+    // Keep the order log in columnar form (call before process()).
+    void setColumnarOrders(bool fixed_point) {
+        columnar_orders = true;
+        order_cols = OrderColumns(fixed_point);
+        for (auto& sh : shards) {
+            size_t cap = sh.orders.capacity();
+            sh.orders = {};
+            sh.order_cols = OrderColumns(fixed_point);
+            sh.order_cols.reserve(cap);
+        }
+    }
+
+    void process() {
+        if (cols) processFeed(*cols);
+        else if (mapped) processFeed(*mapped);
+        else if (rows) processFeed(*rows);
+        mergeShards();
+    }
+
+    // Streaming mode: consume ticks from `ring` as the producer publishes them
+    // until `done` is set and the ring is drained. Uses the first shard only.
+    void processStream(SpscRing<MarketData>& ring, const std::atomic<bool>& done) {
+        Shard& sh = shards[0];
+        MarketData tick;
+        uint64_t seq = 0;
+        unsigned spins = 0;
+        for (;;) {
+            if (ring.tryPop(tick)) {
+                processTick(sh, tick, seq++);
+                spins = 0;
+            } else if (done.load(std::memory_order_acquire)) {
+                if (!ring.tryPop(tick)) break;
+                processTick(sh, tick, seq++);
+            } else {
+                // don't let a partial lane block wait on the producer
+                if (sh.lanes.count) flushLanes(sh);
+                idle_polls++;
+                backoff(spins);
+            }
+        }
+        flushLanes(sh);
+        ticks_processed = seq;
+        mergeShards();
+    }
+
+    // Latency histogram precision (sub-bucket bits); call before process().
+    void setLatencyPrecision(int sub_bits) {
+        latency_hist = LatencyHistogram(sub_bits);
+        for (auto& sh : shards) {
+            sh.latency_hist = LatencyHistogram(sub_bits);
+            sh.interval_hist = LatencyHistogram(sub_bits);
+        }
+    }
+
+    // Print an interval latency snapshot every `ticks` ticks per shard (0 = off).
+    void setSnapshotInterval(size_t ticks) { snapshot_every = ticks; }
+
+    void reportStats() const {
+        cout << "\n--- Performance Report ---\n";
+        cout << "Total Market Ticks Processed: " << ticks_processed << "\n";
+        cout << "Engine Threads: " << shards.size() << "\n";
+        cout << "Total Orders Placed: " << orderCount() << "\n";
+        cout << "Average Tick-to-Trade Latency (ns): " << latency_hist.mean() << "\n";
+        cout << "Max Tick-to-Trade Latency (ns): " << latency_hist.max() << "\n";
+        if (latency_hist.count()) {
+            cout << "p50/p90/p99/p99.9/p99.99 Latency (ns): ";
+            latency_hist.printPercentiles(cout);
+            cout << "\n";
+        }
+        cout << "\nPer-signal order attributions (orders where the signal fired):\n";
+        Pipeline::report(cout, per_signal_counts);
+        if (!shards[0].rolling.empty()) reportRolling(shards[0].rolling[0], shards[0].lo);
+#if ENABLE_TSC_PROFILE
+        reportProfile();
+#endif
+    }
+
+    static void reportRolling(const InstrumentStats& r, int id) {
+        cout << "\nRolling statistics, instrument " << id << " (" << r.samples() << " ticks):\n";
+        cout << "  window     mean      stddev    min       max       ema       vwap\n";
+        for (size_t w = 0; w < InstrumentStats::NW; ++w) {
+            cout << "  " << std::left << std::setw(8) << InstrumentStats::windows[w] << std::right
+                 << std::fixed << std::setprecision(4)
+                 << std::setw(10) << r.mean(w) << std::setw(10) << r.stddev(w)
+                 << std::setw(10) << r.min(w) << std::setw(10) << r.max(w)
+                 << std::setw(10) << r.ema(w) << std::setw(10) << r.vwap(w) << "\n";
+        }
+        cout.unsetf(std::ios::floatfield);
+        cout << std::setprecision(6);
+    }
+
+    // Cycle breakdown per stage, normalised per tick (one history update per tick).
+    void reportProfile() const {
+        const StageProfile p = ProfileRegistry::snapshot();
+        const double ticks = double(std::max<uint64_t>(1, p.calls[STAGE_HISTORY]));
+        uint64_t total = 0;
+        for (int i = 0; i < STAGE_COUNT; ++i) total += p.cycles[i];
+        cout << "\nTick-path cycle breakdown (TSC, " << std::setprecision(3)
+             << TscClock::ns_per_tick << " ns/cycle):\n";
+        auto line = [&](const std::string& label, int st) {
+            if (!p.calls[st]) return;
+            std::string l = label;
+            if (l.size() < 17) l.resize(17, ' ');
+            cout << "  " << l << ": calls " << p.calls[st]
+                 << "  cycles/call " << std::fixed << std::setprecision(1) << double(p.cycles[st]) / double(p.calls[st])
+                 << "  cycles/tick " << double(p.cycles[st]) / ticks
+                 << "  share " << (total ? 100.0 * double(p.cycles[st]) / double(total) : 0.0) << "%\n";
+        };
+        line("History update", STAGE_HISTORY);
+        for (size_t i = 0; i < Pipeline::N; ++i) line(Pipeline::names[i], STAGE_SIGNAL + int(i));
+        line("SIMD signals", STAGE_SIMD_SIGNALS);
+        line("Rolling stats", STAGE_ROLLING);
+        line("Order construct", STAGE_ORDER);
+        cout << "  Total            : " << double(total) / ticks << " cycles/tick ("
+             << double(total) / ticks * TscClock::ns_per_tick << " ns/tick)\n";
+        cout.unsetf(std::ios::floatfield);
+        cout << std::setprecision(6);
+    }
+
+    // Bonus: write CSV of orders
+    void exportCSV(const std::string& path = "orders.csv") const {
+        if (journal) return; // already streamed out
+        if (columnar_orders) writeOrdersCSV(order_cols, path);
+        else writeOrdersCSV(orders, path);
+    }
+
+    // expose counts for the write-up
+    const Counts& signalCounts() const { return per_signal_counts; }
+    const LatencyHistogram& latencyHistogram() const { return latency_hist; }
+    // Hand orders to a background journal instead of keeping them in memory.
+    // The journal needs one producer ring per shard; exportCSV/orderAt are
+    // then unavailable.
+    // False (nothing attached) if the journal has fewer rings than shards.
+    bool attachJournal(OrderJournal* j) {
+        if (j && j->producers() < int(shards.size())) {
+            cerr << "Error: order journal has fewer rings than engine shards\n";
+            return false;
+        }
+        journal = j;
+        if (journal)
+            for (auto& sh : shards) { sh.orders = {}; sh.order_seq = {}; }
+        return true;
+    }
+
+    size_t orderCount() const { return orders_placed; }
+    Order orderAt(size_t i) const { return columnar_orders ? order_cols[i] : orders[i]; }
+    // Feed index of the tick that produced order i.
+    size_t orderTick(size_t i) const { return order_seq[i]; }
+    size_t idlePolls() const { return idle_polls; }
+    size_t shardCount() const { return shards.size(); }
+
+    // Publish live counters into a shared-memory segment (see hft_metrics.h)
+    // laid out for at least shardCount() shards and every instrument.
+    void attachMetrics(MetricsSegment* m) {
+        if (m && (m->header().n_shards < shards.size() || m->header().n_instruments < owner.size())) {
+            cerr << "Error: metrics segment is smaller than the engine\n";
+            return;
+        }
+        for (size_t w = 0; w < shards.size(); ++w) {
+            shards[w].metrics = m ? &m->shard(int(w)) : nullptr;
+            shards[w].inst_metrics = m ? &m->instrument(0) : nullptr;
+        }
+    }
+
+private:
+    // Everything one worker touches on the hot path. Histories are indexed by
+    // (instrument_id - lo); alignas keeps neighbouring shards off each other's lines.
+    struct alignas(64) Shard {
+        int lo = 0, hi = 0; // owned instruments [lo, hi)
+        std::vector<History> price_hist; // small, cache-friendly window
+        std::vector<InstrumentStats> rolling; // empty unless --rolling
+        std::vector<Order> orders;
+        OrderColumns order_cols;         // used instead of orders when columnar
+        std::vector<uint64_t> order_seq; // feed index of each order, merge key
+        size_t orders_placed = 0;
+        LatencyHistogram latency_hist;   // whole run
+        LatencyHistogram interval_hist;  // since last snapshot (snapshot mode)
+        size_t ticks_seen = 0;
+        Counts per_signal_counts{};
+        SignalLanes lanes;               // pending batch (batched mode)
+        MetricsShard* metrics = nullptr;           // live counters, this shard only writes them
+        MetricsInstrument* inst_metrics = nullptr; // indexed by instrument_id
+    };
+
+    const std::vector<MarketData>* rows = nullptr;  // row feed, or
+    const MarketDataColumns* cols = nullptr;        // columnar feed
+    MappedTickFile* mapped = nullptr;               // mmap replay
+    bool columnar_orders = false;
+    bool batched = false;
+    OrderJournal* journal = nullptr;
+    size_t orders_placed = 0;
+    size_t ticks_processed = 0;
+    size_t idle_polls = 0; // streaming: empty-ring polls by the consumer
+    std::vector<Shard> shards;
+    std::vector<int> owner; // instrument_id -> shard
+    std::vector<Order> orders;
+    OrderColumns order_cols;
+    std::vector<uint64_t> order_seq; // feed index per merged order
+    LatencyHistogram latency_hist;
+    size_t snapshot_every = 0;
+    static inline std::mutex snapshot_mu; // serializes snapshot lines from shard workers
+    Counts per_signal_counts;
+
+    void init(size_t feed_size, int n_instruments, int n_threads) {
+        int n = std::clamp(n_threads, 1, std::max(1, n_instruments));
+        shards.resize(n);
+        for (int w = 0; w < n; ++w) {
+            Shard& sh = shards[w];
+            sh.lo = int((long long)n_instruments * w / n);
+            sh.hi = int((long long)n_instruments * (w + 1) / n);
+            sh.price_hist.resize(sh.hi - sh.lo);
+            sh.orders.reserve(feed_size / 10 / n); // heuristic
+        }
+        owner.resize(n_instruments);
+        for (int w = 0; w < n; ++w)
+            for (int id = shards[w].lo; id < shards[w].hi; ++id) owner[id] = w;
+    }
+
+    // Feed is either the row vector or MarketDataColumns; both index to a tick.
+    template<class Feed>
+    void processFeed(Feed& feed) {
+        if (shards.size() == 1) {
+            Shard& sh = shards[0];
+            constexpr size_t RELEASE_EVERY = size_t(1) << 16;
+            for (size_t i = 0; i < feed.size(); ++i) {
+                processTick(sh, feed[i], i);
+                if constexpr (std::is_same_v<Feed, MappedTickFile>)
+                    if ((i + 1) % RELEASE_EVERY == 0) feed.releaseBefore(i + 1);
+            }
+            flushLanes(sh);
+        } else {
+            processSharded(feed);
+        }
+        ticks_processed = feed.size();
+    }
+
+    inline void processTick(Shard& sh, const MarketData& tick, uint64_t seq) {
+        if (batched) pushLane(sh, tick, seq);
+        else onTick(sh, tick, seq);
+        if (sh.metrics) publishTick(sh, tick);
+        if (snapshot_every && ++sh.ticks_seen % snapshot_every == 0) snapshot(sh);
+    }
+
+    // Print the interval histogram, then fold it into the shard's total.
+    void snapshot(Shard& sh) {
+        {
+            std::lock_guard<std::mutex> lock(snapshot_mu);
+            cout << "[latency snapshot] shard " << (&sh - shards.data()) << " ticks " << sh.ticks_seen
+                 << " orders " << sh.interval_hist.count() << " p50/p90/p99/p99.9/p99.99 ";
+            sh.interval_hist.printPercentiles(cout);
+            cout << " max " << sh.interval_hist.max() << "\n";
+        }
+        sh.latency_hist.merge(sh.interval_hist);
+        sh.interval_hist.reset();
+    }
+
+    inline void onTick(Shard& sh, const MarketData& tick, uint64_t seq) {
+        auto& hist = sh.price_hist[tick.instrument_id - sh.lo];
+        {
+            HFT_PROFILE_SCOPE(STAGE_HISTORY);
+            hist.add(tick.price);
+        }
+        updateRolling(sh, tick);
+
+        // signals -> accumulate buy/sell "votes"
+        int buy_votes = 0, sell_votes = 0;
+        uint32_t mask = Pipeline::eval(tick.price, hist, buy_votes, sell_votes);
+
+        if (buy_votes || sell_votes)
+            emitOrder(sh, tick.instrument_id, tick.price, tick.timestamp, buy_votes, sell_votes, mask, seq);
+    }
+
+    inline void emitOrder(Shard& sh, int id, double price, Clock::time_point tick_ts,
+                          int buy_votes, int sell_votes, uint32_t mask, uint64_t seq) {
+        HFT_PROFILE_SCOPE(STAGE_ORDER);
+        bool is_buy = (buy_votes > sell_votes) || (buy_votes == sell_votes && (id & 1));
+        auto now = Clock::now();
+        double px = price + (is_buy ? 0.01 : -0.01);
+        Order o{id, px, is_buy, mask, now};
+        sh.orders_placed++;
+        if (journal) {
+            journal->push(int(&sh - shards.data()), o);
+        } else {
+            if (columnar_orders) sh.order_cols.push(o);
+            else sh.orders.push_back(o);
+            sh.order_seq.push_back(seq);
+        }
+
+        auto latency = std::chrono::duration_cast<ns>(now - tick_ts).count();
+        (snapshot_every ? sh.interval_hist : sh.latency_hist).record(latency);
+
+        // track per-signal contributions (if that bit fired, attribute this order too)
+        Pipeline::count(mask, sh.per_signal_counts);
+        if (sh.metrics) publishOrder(sh, id, is_buy, mask, latency);
+    }
+
+    // Live metrics: plain stores into memory only this shard writes.
+    inline void publishTick(Shard& sh, const MarketData& tick) {
+        metricsAdd(sh.metrics->ticks, uint64_t(1));
+        MetricsInstrument& m = sh.inst_metrics[tick.instrument_id];
+        const uint32_t s = metricsBeginWrite(m);
+        metricsAdd(m.ticks, uint64_t(1));
+        m.last_price.store(tick.price, std::memory_order_relaxed);
+        m.avg_price.store(sh.price_hist[tick.instrument_id - sh.lo].avg(), std::memory_order_relaxed);
+        metricsEndWrite(m, s);
+    }
+
+    inline void publishOrder(Shard& sh, int id, bool is_buy, uint32_t mask, int64_t latency) {
+        MetricsShard& ms = *sh.metrics;
+        metricsAdd(ms.orders, uint64_t(1));
+        metricsAdd(ms.buys, uint64_t(is_buy));
+        for (uint32_t b = mask & ((1u << METRICS_MAX_SIGNALS) - 1); b; b &= b - 1)
+            metricsAdd(ms.signals[__builtin_ctz(b)], uint64_t(1));
+        metricsAdd(ms.latency[metricsLatencyBucket(latency)], uint64_t(1));
+        MetricsInstrument& m = sh.inst_metrics[id];
+        const uint32_t s = metricsBeginWrite(m);
+        metricsAdd(m.orders, uint64_t(1));
+        metricsAdd(m.position, int64_t(is_buy ? 1 : -1));
+        m.last_mask.store(mask, std::memory_order_relaxed);
+        metricsEndWrite(m, s);
+    }
+
+    inline void updateRolling(Shard& sh, const MarketData& tick) {
+        if (sh.rolling.empty()) return;
+        HFT_PROFILE_SCOPE(STAGE_ROLLING);
+        sh.rolling[tick.instrument_id - sh.lo].add(tick.price);
+    }
+
+    // Batched mode: update the history right away (it is scalar and
+    // order-dependent), then park the tick in a lane. A block is evaluated
+    // when full, or early if this instrument already has a pending lane.
+    inline void pushLane(Shard& sh, const MarketData& tick, uint64_t seq) {
+        SignalLanes& L = sh.lanes;
+        for (int k = 0; k < L.count; ++k)
+            if (L.id[k] == tick.instrument_id) { flushLanes(sh); break; }
+
+        auto& hist = sh.price_hist[tick.instrument_id - sh.lo];
+        {
+            HFT_PROFILE_SCOPE(STAGE_HISTORY);
+            hist.add(tick.price);
+        }
+        updateRolling(sh, tick);
+        const int k = L.count++;
+        L.price[k] = tick.price;
+        L.n[k] = double(hist.size);
+        L.sum[k] = hist.sum;
+        L.sumsq[k] = hist.sumsq;
+        L.a[k] = L.b[k] = L.c[k] = 0.0;
+        if (!hist.last3(L.a[k], L.b[k], L.c[k])) hist.last(L.c[k]);
+        L.id[k] = tick.instrument_id;
+        L.seq[k] = seq;
+        L.ts[k] = tick.timestamp;
+        if (L.count == SignalLanes::W) flushLanes(sh);
+    }
+
+    void flushLanes(Shard& sh) {
+        SignalLanes& L = sh.lanes;
+        if (!L.count) return;
+        // Idle lanes get n = 1 and zeros so they stay finite and never vote.
+        for (int k = L.count; k < SignalLanes::W; ++k) {
+            L.price[k] = 150.0; L.n[k] = 1.0;
+            L.sum[k] = L.sumsq[k] = L.a[k] = L.b[k] = L.c[k] = 0.0;
+        }
+        SignalVotes v;
+        {
+            HFT_PROFILE_SCOPE(STAGE_SIMD_SIGNALS);
+            v = evalSignalLanes(L);
+        }
+        constexpr int N_SIG = int(Pipeline::N);
+        for (int k = 0; k < L.count; ++k) {
+            int buy_votes = 0, sell_votes = 0;
+            uint32_t mask = 0;
+            for (int s = 0; s < N_SIG; ++s) {
+                uint32_t bv = (v.buy[s] >> k) & 1u, sv = (v.sell[s] >> k) & 1u;
+                buy_votes += int(bv);
+                sell_votes += int(sv);
+                mask |= (bv | sv) << s;
+            }
+            if (mask)
+                emitOrder(sh, L.id[k], L.price[k], L.ts[k], buy_votes, sell_votes, mask, L.seq[k]);
+        }
+        L.count = 0;
+    }
+
+    // The feed is walked in windows of WINDOW ticks, two phases per window,
+    // each one thread per shard:
+    //  1. worker c buckets slice c of the window by owning shard (indices only);
+    //  2. worker w replays buckets[0..n)[w] in slice order, so every instrument
+    //     still sees its ticks in feed order and the signals match the serial path.
+    // The buckets are reused, so their size is bounded by the window, and a
+    // mapped tick file drops each window's pages once it has been replayed.
+    static constexpr size_t WINDOW = size_t(1) << 20;
+
+    template<class Feed>
+    void processSharded(Feed& feed) {
+        const size_t n = shards.size();
+        const size_t total = feed.size();
+        std::vector<std::vector<std::vector<size_t>>> buckets(n, std::vector<std::vector<size_t>>(n));
+
+        auto run_all = [&](auto&& fn) {
+            std::vector<std::thread> pool;
+            pool.reserve(n);
+            for (size_t w = 0; w < n; ++w)
+                pool.emplace_back([&, w] { pinThreadToCore(unsigned(w)); fn(w); });
+            for (auto& t : pool) t.join();
+        };
+
+        for (size_t w0 = 0; w0 < total; w0 += WINDOW) {
+            const size_t len = std::min(WINDOW, total - w0);
+            run_all([&](size_t c) {
+                const size_t begin = w0 + len * c / n, end = w0 + len * (c + 1) / n;
+                auto& mine = buckets[c];
+                for (auto& b : mine) { b.clear(); b.reserve((end - begin) / n + 16); }
+                for (size_t i = begin; i < end; ++i)
+                    mine[owner[instrumentAt(feed, i)]].push_back(i);
+            });
+
+            run_all([&](size_t w) {
+                Shard& sh = shards[w];
+                for (size_t c = 0; c < n; ++c)
+                    for (size_t i : buckets[c][w]) processTick(sh, feed[i], i);
+            });
+            if constexpr (std::is_same_v<Feed, MappedTickFile>) feed.releaseBefore(w0 + len);
+        }
+        for (auto& sh : shards) flushLanes(sh);
+    }
+
+    // Bucketing only needs the id column, so don't rebuild whole ticks for it.
+    static int instrumentAt(const std::vector<MarketData>& feed, size_t i) { return feed[i].instrument_id; }
+    template<class Feed>
+    static int instrumentAt(const Feed& feed, size_t i) { return feed.idAt(i); }
+
+    // Gather shard results in feed order, which is exactly the order the
+    // single-threaded loop would have produced them in.
+    void mergeShards() {
+        orders_placed = 0;
+        for (auto& sh : shards) {
+            orders_placed += sh.orders_placed;
+            sh.latency_hist.merge(sh.interval_hist); // partial last interval
+            sh.interval_hist.reset();
+            latency_hist.merge(sh.latency_hist);
+        }
+        if (shards.size() == 1) {
+            Shard& sh = shards[0];
+            orders = std::move(sh.orders);
+            order_cols = std::move(sh.order_cols);
+            order_seq = std::move(sh.order_seq);
+            per_signal_counts = sh.per_signal_counts;
+            return;
+        }
+        size_t total = 0;
+        for (const auto& sh : shards) total += sh.order_seq.size();
+        if (columnar_orders) order_cols.reserve(total);
+        else orders.reserve(total);
+        order_seq.reserve(total);
+
+        using Head = std::pair<uint64_t, size_t>; // (feed index, shard)
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+        std::vector<size_t> pos(shards.size(), 0);
+        for (size_t w = 0; w < shards.size(); ++w)
+            if (!shards[w].order_seq.empty()) heap.emplace(shards[w].order_seq[0], w);
+        while (!heap.empty()) {
+            size_t w = heap.top().second;
+            heap.pop();
+            const Shard& sh = shards[w];
+            size_t k = pos[w]++;
+            if (columnar_orders) order_cols.append(sh.order_cols, k);
+            else orders.push_back(sh.orders[k]);
+            order_seq.push_back(sh.order_seq[k]);
+            if (pos[w] < sh.order_seq.size()) heap.emplace(sh.order_seq[pos[w]], w);
+        }
+        per_signal_counts = {};
+        for (const auto& sh : shards)
+            for (size_t s = 0; s < Pipeline::N; ++s) per_signal_counts[s] += sh.per_signal_counts[s];
+    }
+};
+
+using TradeEngine = TradeEngineT<>;
+
+// --------------------------- Order Book & Matching ---------------------------
+// Price-level limit order book on an integer tick grid. Each instrument owns a
+// flat Level array indexed by tick (FIFO of resting orders plus aggregate
+// size) and one two-level bitmap per side, so the next non-empty level is a
+// couple of ctz/clz away. Orders live in a shared intrusive pool: the prev/next
+// links sit in the node itself and freed nodes go on a free list, so adding
+// and cancelling never touch the heap. Handles carry a generation, so
+// cancelling an order that has already been filled is a harmless no-op.
+
+// One bit per tick plus a summary bit per 64-tick word.
+class LevelBitmap {
+public:
+    void resize(int32_t n) {
+        n_bits = n;
+        words.assign(size_t(n + 63) / 64, 0);
+        summary.assign((words.size() + 63) / 64, 0);
+    }
+
+    inline void set(int32_t i) {
+        words[size_t(i) >> 6] |= uint64_t(1) << (i & 63);
+        summary[size_t(i) >> 12] |= uint64_t(1) << ((i >> 6) & 63);
+    }
+    inline void clear(int32_t i) {
+        uint64_t& w = words[size_t(i) >> 6];
+        w &= ~(uint64_t(1) << (i & 63));
+        if (!w) summary[size_t(i) >> 12] &= ~(uint64_t(1) << ((i >> 6) & 63));
+    }
+
+    // Lowest set index >= i, or -1.
+    int32_t next(int32_t i) const {
+        if (i >= n_bits) return -1;
+        i = std::max(i, 0);
+        int32_t w = i >> 6;
+        uint64_t m = words[w] & (~uint64_t(0) << (i & 63));
+        if (m) return (w << 6) + __builtin_ctzll(m);
+        if (++w >= int32_t(words.size())) return -1;
+        int32_t s = w >> 6;
+        uint64_t sm = summary[s] & (~uint64_t(0) << (w & 63));
+        while (!sm) {
+            if (++s >= int32_t(summary.size())) return -1;
+            sm = summary[s];
+        }
+        w = (s << 6) + __builtin_ctzll(sm);
+        return (w << 6) + __builtin_ctzll(words[w]);
+    }
+
+    // Highest set index <= i, or -1.
+    int32_t prev(int32_t i) const {
+        if (i < 0) return -1;
+        i = std::min(i, n_bits - 1);
+        int32_t w = i >> 6;
+        uint64_t m = words[w] & (~uint64_t(0) >> (63 - (i & 63)));
+        if (m) return (w << 6) + 63 - __builtin_clzll(m);
+        if (--w < 0) return -1;
+        int32_t s = w >> 6;
+        uint64_t sm = summary[s] & (~uint64_t(0) >> (63 - (w & 63)));
+        while (!sm) {
+            if (--s < 0) return -1;
+            sm = summary[s];
+        }
+        w = (s << 6) + 63 - __builtin_clzll(sm);
+        return (w << 6) + 63 - __builtin_clzll(words[w]);
+    }
+
+private:
+    int32_t n_bits = 0;
+    std::vector<uint64_t> words, summary;
+};
+
+enum class BookSide : uint8_t { Bid = 0, Ask = 1 };
+
+// Node storage shared by every book. The pool only grows (doubling) when all
+// nodes are in use, so steady-state add/cancel/fill is allocation free.
+class BookOrderPool {
+public:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint64_t INVALID = UINT64_MAX;
+
+    struct Node {
+        int64_t qty;
+        int32_t tick;
+        uint32_t prev, next;   // level FIFO links; `next` doubles as the free-list link
+        uint32_t gen;          // bumped on free, so stale handles stop matching
+        uint32_t owner;        // caller tag (e.g. maker id)
+        uint32_t book;         // id of the book the order rests in; the pool may be shared
+        BookSide side;
+        bool live;
+    };
+
+    explicit BookOrderPool(size_t capacity = 1024) { grow(std::max<size_t>(capacity, 1)); }
+
+    inline uint32_t alloc() {
+        if (free_head == NIL) grow(nodes.size() * 2);
+        uint32_t i = free_head;
+        free_head = nodes[i].next;
+        nodes[i].live = true;
+        n_live++;
+        return i;
+    }
+    inline void release(uint32_t i) {
+        Node& n = nodes[i];
+        n.live = false;
+        n.gen++;
+        n.next = free_head;
+        free_head = i;
+        n_live--;
+    }
+
+    inline Node& operator[](uint32_t i) { return nodes[i]; }
+    inline const Node& operator[](uint32_t i) const { return nodes[i]; }
+
+    inline uint64_t handle(uint32_t i) const { return (uint64_t(nodes[i].gen) << 32) | i; }
+    // Pool index of a handle that still names a resting order, or NIL.
+    inline uint32_t resolve(uint64_t h) const {
+        uint32_t i = uint32_t(h);
+        if (h == INVALID || i >= nodes.size()) return NIL;
+        const Node& n = nodes[i];
+        return (n.live && n.gen == uint32_t(h >> 32)) ? i : NIL;
+    }
+
+    size_t capacity() const { return nodes.size(); }
+    size_t live() const { return n_live; }
+    size_t bytes() const { return nodes.capacity() * sizeof(Node); }
+
+private:
+    std::vector<Node> nodes;
+    uint32_t free_head = NIL;
+    size_t n_live = 0;
+
+    void grow(size_t cap) {
+        size_t old = nodes.size();
+        nodes.resize(cap);
+        for (size_t i = cap; i-- > old;) {   // lowest new index ends up first on the free list
+            nodes[i] = Node{0, 0, NIL, free_head, 0, 0, 0, BookSide::Bid, false};
+            free_head = uint32_t(i);
+        }
+    }
+};
+
+class LimitOrderBook {
+public:
+    // `id` tells this book's orders apart from other books sharing the pool.
+    LimitOrderBook(BookOrderPool& p, int32_t n_ticks, uint32_t id = 0)
+        : pool(&p), levels(size_t(n_ticks)), best_ask(n_ticks), book_id(id) {
+        bids.resize(n_ticks);
+        asks.resize(n_ticks);
+    }
+
+    int32_t ticks() const { return int32_t(levels.size()); }
+    int32_t bestBid() const { return best_bid; }             // -1 when empty
+    int32_t bestAsk() const { return best_ask; }             // ticks() when empty
+    int64_t levelQty(int32_t tick) const { return levels[tick].qty; }
+    size_t restingOrders() const { return resting; }
+
+    // Post-only: rest `qty` at `tick` behind any orders already there. Returns
+    // INVALID (and rests nothing) if the tick is off the grid or would cross.
+    uint64_t add(BookSide side, int32_t tick, int64_t qty, uint32_t owner = 0) {
+        if (tick < 0 || tick >= ticks() || qty <= 0) return BookOrderPool::INVALID;
+        if (side == BookSide::Bid ? tick >= best_ask : tick <= best_bid) return BookOrderPool::INVALID;
+        const uint32_t i = pool->alloc();
+        BookOrderPool::Node& n = (*pool)[i];
+        Level& L = levels[tick];
+        n.qty = qty; n.tick = tick; n.owner = owner; n.book = book_id; n.side = side;
+        n.prev = L.tail; n.next = BookOrderPool::NIL;
+        if (L.tail != BookOrderPool::NIL) (*pool)[L.tail].next = i;
+        else {
+            L.head = i;
+            if (side == BookSide::Bid) { bids.set(tick); best_bid = std::max(best_bid, tick); }
+            else { asks.set(tick); best_ask = std::min(best_ask, tick); }
+        }
+        L.tail = i;
+        L.qty += qty;
+        resting++;
+        return pool->handle(i);
+    }
+
+    // O(1): unlink from the level FIFO; a level that empties leaves the bitmap.
+    // A handle that is stale or rests in another book is rejected.
+    bool cancel(uint64_t h) {
+        const uint32_t i = pool->resolve(h);
+        if (i == BookOrderPool::NIL || (*pool)[i].book != book_id) return false;
+        unlink(i);
+        return true;
+    }
+
+    // Aggressive limit order: take liquidity from the opposite side at prices
+    // no worse than `limit`, best price first and FIFO within a level. Calls
+    // on_fill(tick, qty, owner) per maker order touched and returns the filled
+    // quantity; nothing rests (IOC), the caller decides what to do with the rest.
+    template<class OnFill>
+    int64_t match(BookSide aggressor, int32_t limit, int64_t qty, OnFill&& on_fill) {
+        int64_t filled = 0;
+        const bool buy = aggressor == BookSide::Bid;
+        while (qty > 0) {
+            const int32_t px = buy ? best_ask : best_bid;
+            if (buy ? (px >= ticks() || px > limit) : (px < 0 || px < limit)) break;
+            Level& L = levels[px];
+            while (qty > 0 && L.head != BookOrderPool::NIL) {
+                const uint32_t i = L.head;
+                BookOrderPool::Node& n = (*pool)[i];
+                const int64_t take = std::min(qty, n.qty);
+                on_fill(px, take, n.owner);
+                qty -= take;
+                filled += take;
+                if (take == n.qty) unlink(i);          // may empty the level and move best
+                else { n.qty -= take; L.qty -= take; }
+            }
+        }
+        return filled;
+    }
+
+private:
+    struct Level {
+        uint32_t head = BookOrderPool::NIL, tail = BookOrderPool::NIL;
+        int64_t qty = 0;
+    };
+
+    BookOrderPool* pool;
+    std::vector<Level> levels;
+    LevelBitmap bids, asks;
+    int32_t best_bid = -1, best_ask;
+    uint32_t book_id;
+    size_t resting = 0;
+
+    void unlink(uint32_t i) {
+        BookOrderPool::Node& n = (*pool)[i];
+        Level& L = levels[n.tick];
+        if (n.prev != BookOrderPool::NIL) (*pool)[n.prev].next = n.next; else L.head = n.next;
+        if (n.next != BookOrderPool::NIL) (*pool)[n.next].prev = n.prev; else L.tail = n.prev;
+        L.qty -= n.qty;
+        if (L.head == BookOrderPool::NIL) {
+            if (n.side == BookSide::Bid) {
+                bids.clear(n.tick);
+                if (n.tick == best_bid) best_bid = bids.prev(n.tick - 1);
+            } else {
+                asks.clear(n.tick);
+                if (n.tick == best_ask) {
+                    const int32_t nx = asks.next(n.tick + 1);
+                    best_ask = nx < 0 ? ticks() : nx;
+                }
+            }
+        }
+        resting--;
+        pool->release(i);
+    }
+};
+
+// Replays a finished run against synthetic passive liquidity. On every feed
+// tick a market maker for that instrument cancels its quotes and re-posts up
+// to `depth` levels per side, one tick apart, starting 1..max_spread ticks
+// from the tick price; each level is left empty with probability gap_prob and
+// gets a random lot. The engine's orders for that tick are then sent as IOC
+// limit orders of random size at their own price (tick price +/- 0.01) pushed
+// 0..max_reach ticks further, so some miss the touch, some fill at one level
+// and some sweep several. All draws come from `seed`, so a run is repeatable.
+// Book ops are counted; each match() call is timed with the TSC.
+struct LobConfig {
+    int depth = 5;              // maker levels per side
+    int64_t maker_lot = 100;    // mean size per maker level (drawn from 1..2*lot-1)
+    int64_t order_qty = 100;    // mean size of an engine order (drawn from 1..2*qty-1)
+    int max_spread = 3;         // first maker level 1..max_spread ticks from the price
+    double gap_prob = 0.2;      // chance a maker level is not posted
+    int max_reach = 3;          // extra ticks an order's limit may reach past its price
+    uint64_t seed = 0xC0FFEE;
+    double tick_size = 0.01;
+    double min_price = 50.0, max_price = 500.0;   // MarketDataFeed clamps to this range
+};
+
+class MatchingSim {
+public:
+    MatchingSim(int n_instruments, const LobConfig& c, int latency_bits = 8)
+        : cfg(c), pool(size_t(n_instruments) * 2 * size_t(std::max(c.depth, 1)) + 64),
+          fill_latency(latency_bits), rng(c.seed) {
+        cfg.depth = std::max(cfg.depth, 1);
+        cfg.maker_lot = std::max<int64_t>(cfg.maker_lot, 1);
+        cfg.order_qty = std::max<int64_t>(cfg.order_qty, 1);
+        cfg.max_spread = std::max(cfg.max_spread, 1);
+        cfg.max_reach = std::max(cfg.max_reach, 0);
+        const int margin = cfg.depth + cfg.max_spread + cfg.max_reach + 1;
+        min_tick = std::llround(cfg.min_price / cfg.tick_size) - margin;
+        const int32_t n_ticks = int32_t(std::llround(cfg.max_price / cfg.tick_size) - min_tick + margin + 1);
+        books.reserve(n_instruments);
+        for (int i = 0; i < n_instruments; ++i) books.emplace_back(pool, n_ticks, uint32_t(i));
+        quotes.assign(size_t(n_instruments) * 2 * cfg.depth, BookOrderPool::INVALID);
+    }
+
+    // Feed: anything indexable by tick (row vector, columns, mapped file).
+    // Engine: a finished TradeEngineT holding its orders in memory.
+    template<class Feed, class Engine>
+    void run(const Feed& feed, const Engine& engine) {
+        const uint64_t t0 = readTsc();
+        size_t k = 0;
+        const size_t n_orders = engine.orderCount();
+        for (size_t i = 0; i < feed.size(); ++i) {
+            const MarketData tick = feed[i];
+            requote(tick.instrument_id, toTick(tick.price));
+            for (; k < n_orders && engine.orderTick(k) == i; ++k) matchOrder(engine.orderAt(k));
+        }
+        total_cycles += readTsc() - t0;
+    }
+
+    void report() const {
+        const double ns_per_cycle = TscClock::ns_per_tick;
+        const double match_s = double(match_cycles) * ns_per_cycle * 1e-9;
+        const double total_s = double(total_cycles) * ns_per_cycle * 1e-9;
+        const uint64_t ops = adds + cancels + orders;
+        cout << "\n--- Order Book Simulation ---\n";
+        cout << "Maker Quotes (adds / cancels): " << adds << " / " << cancels
+             << "  (depth " << cfg.depth << ", mean lot " << cfg.maker_lot << ", spread 1-" << cfg.max_spread
+             << ", gap " << cfg.gap_prob << ")\n";
+        cout << "IOC Orders Matched: " << orders << "  (mean qty " << cfg.order_qty << ", reach 0-" << cfg.max_reach << ")\n";
+        cout << "  Full / Partial / Unfilled: " << full << " / " << partial << " / " << (orders - full - partial) << "\n";
+        cout << "  Fills (maker orders hit): " << fills << ", filled qty " << filled_qty
+             << " (" << std::fixed << std::setprecision(1)
+             << (sent_qty ? 100.0 * double(filled_qty) / double(sent_qty) : 0.0) << "%)\n";
+        cout << "  Levels swept per filled order (avg / max): "
+             << (full + partial ? double(levels_swept) / double(full + partial) : 0.0) << " / " << max_levels << "\n";
+        cout << "Match Throughput (orders/s): " << std::setprecision(0) << (match_s > 0 ? double(orders) / match_s : 0.0)
+             << "\nBook Ops Throughput (adds+cancels+matches/s): " << (total_s > 0 ? double(ops) / total_s : 0.0) << "\n";
+        cout.unsetf(std::ios::floatfield);
+        cout << std::setprecision(6);
+        if (fill_latency.count()) {
+            cout << "Fill Latency p50/p90/p99/p99.9/p99.99 (ns): ";
+            fill_latency.printPercentiles(cout);
+            cout << "  max " << fill_latency.max() << "\n";
+        }
+        cout << "Order Pool: " << pool.capacity() << " nodes (" << pool.bytes() / 1024 << " KB), "
+             << pool.live() << " resting at end; book levels " << books.size() << " x " << (books.empty() ? 0 : books[0].ticks()) << "\n";
+    }
+
+    const LatencyHistogram& fillLatency() const { return fill_latency; }
+
+private:
+    LobConfig cfg;
+    BookOrderPool pool;
+    std::vector<LimitOrderBook> books;
+    std::vector<uint64_t> quotes;   // maker handles, 2*depth per instrument (bids then asks)
+    int64_t min_tick = 0;
+    LatencyHistogram fill_latency;  // ns per match() call
+    std::mt19937_64 rng;
+    uint64_t adds = 0, cancels = 0, orders = 0, full = 0, partial = 0, fills = 0;
+    uint64_t levels_swept = 0, max_levels = 0;
+    int64_t filled_qty = 0, sent_qty = 0;
+    uint64_t match_cycles = 0, total_cycles = 0;
+
+    // Uniform in [lo, hi]; outside the timed match() window.
+    inline int64_t draw(int64_t lo, int64_t hi) { return lo + int64_t(rng() % uint64_t(hi - lo + 1)); }
+    inline bool drawGap() { return cfg.gap_prob > 0 && double(rng() >> 11) * 0x1.0p-53 < cfg.gap_prob; }
+
+    inline int32_t toTick(double px) const { return int32_t(std::llround(px / cfg.tick_size) - min_tick); }
+
+    void requote(int id, int32_t mid) {
+        LimitOrderBook& book = books[id];
+        uint64_t* q = &quotes[size_t(id) * 2 * cfg.depth];
+        for (int j = 0; j < 2 * cfg.depth; ++j) {
+            cancels += book.cancel(q[j]);   // filled quotes are already gone
+            q[j] = BookOrderPool::INVALID;
+        }
+        const int32_t bid0 = mid - int32_t(draw(1, cfg.max_spread));
+        const int32_t ask0 = mid + int32_t(draw(1, cfg.max_spread));
+        for (int j = 0; j < cfg.depth; ++j) {
+            if (!drawGap()) q[j] = book.add(BookSide::Bid, bid0 - j, draw(1, 2 * cfg.maker_lot - 1), uint32_t(id));
+            if (!drawGap()) q[cfg.depth + j] = book.add(BookSide::Ask, ask0 + j, draw(1, 2 * cfg.maker_lot - 1), uint32_t(id));
+            adds += (q[j] != BookOrderPool::INVALID) + (q[cfg.depth + j] != BookOrderPool::INVALID);
+        }
+    }
+
+    void matchOrder(const Order& o) {
+        LimitOrderBook& book = books[o.instrument_id];
+        const BookSide side = o.is_buy ? BookSide::Bid : BookSide::Ask;
+        const int32_t reach = int32_t(draw(0, cfg.max_reach));
+        const int32_t limit = toTick(o.price) + (o.is_buy ? reach : -reach);
+        const int64_t qty = draw(1, 2 * cfg.order_qty - 1);
+        int32_t last_px = -1;
+        uint64_t levels = 0;
+        const uint64_t t0 = readTsc();
+        const int64_t got = book.match(side, limit, qty, [&](int32_t px, int64_t, uint32_t) {
+            fills++;
+            levels += px != last_px;
+            last_px = px;
+        });
+        const uint64_t dt = readTsc() - t0;
+        match_cycles += dt;
+        fill_latency.record(int64_t(double(dt) * TscClock::ns_per_tick));
+        orders++;
+        sent_qty += qty;
+        filled_qty += got;
+        full += got == qty;
+        partial += got > 0 && got < qty;
+        levels_swept += levels;
+        max_levels = std::max(max_levels, levels);
+    }
+};
+
+// --------------------------- Parameter Sweep ---------------------------
+// Backtests a grid of strategy constants over one shared, read-only feed.
+// The per-instrument history (and everything derived from it: average,
+// stddev, last moves) does not depend on the constants, so a pass over the
+// feed computes it once per tick and then evaluates a whole block of
+// configurations against it. The block is kept field by field so the inner
+// loop is a straight run of compares and masked adds that vectorizes. Blocks
+// are tasks on per-worker deques with stealing; each configuration is owned by
+// exactly one task, so results do not depend on the thread count.
+
+// Tunable constants of the built-in strategies. The defaults are the values
+// hard-coded in S1/S2/S4 and in evalSignalLanes.
+struct SignalParams {
+    double s1_buy = 105.0, s1_sell = 195.0;   // S1 thresholds
+    double s2_lo = 0.98, s2_hi = 1.02;        // S2 bands around the average
+    double s4_k = 1.75;                       // S4 breakout multiplier
+
+    bool operator==(const SignalParams&) const = default;
+};
+
+struct SweepAxis {
+    std::string name;
+    std::vector<double> values;
+};
+
+// "name=lo:hi:step" (inclusive) or "name=v1,v2,...". Range points are built
+// as integers over a power of ten, so 0.96:1.0:0.01 hits 0.98 exactly.
+inline bool parseSweepAxis(const std::string& spec, SweepAxis& axis) {
+    static constexpr const char* known[] = {"s1_buy", "s1_sell", "s2_lo", "s2_hi", "s4_k"};
+    const size_t eq = spec.find('=');
+    if (eq == std::string::npos) return false;
+    axis.name = spec.substr(0, eq);
+    if (std::find_if(std::begin(known), std::end(known),
+                     [&](const char* k) { return axis.name == k; }) == std::end(known)) return false;
+    const std::string rhs = spec.substr(eq + 1);
+    auto decimals = [](const std::string& s) {
+        size_t dot = s.find('.');
+        return dot == std::string::npos ? 0 : int(s.size() - dot - 1);
+    };
+    axis.values.clear();
+    try {
+        if (rhs.find(':') != std::string::npos) {
+            const size_t c1 = rhs.find(':'), c2 = rhs.find(':', c1 + 1);
+            if (c2 == std::string::npos) return false;
+            const std::string s_lo = rhs.substr(0, c1), s_hi = rhs.substr(c1 + 1, c2 - c1 - 1), s_step = rhs.substr(c2 + 1);
+            const int d = std::max({decimals(s_lo), decimals(s_hi), decimals(s_step)});
+            const double scale = std::pow(10.0, d);
+            const int64_t lo = std::llround(std::stod(s_lo) * scale), hi = std::llround(std::stod(s_hi) * scale);
+            const int64_t step = std::llround(std::stod(s_step) * scale);
+            if (step <= 0 || hi < lo) return false;
+            for (int64_t v = lo; v <= hi; v += step) axis.values.push_back(double(v) / scale);
+        } else {
+            size_t pos = 0;
+            while (pos <= rhs.size()) {
+                size_t comma = rhs.find(',', pos);
+                if (comma == std::string::npos) comma = rhs.size();
+                axis.values.push_back(std::stod(rhs.substr(pos, comma - pos)));
+                pos = comma + 1;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !axis.values.empty();
+}
+
+// Cartesian product of the axes; axes not given keep their default. The
+// defaults themselves are always included (first) as the baseline row.
+inline std::vector<SignalParams> expandGrid(const std::vector<SweepAxis>& axes) {
+    std::vector<SignalParams> grid{SignalParams{}};
+    for (const SweepAxis& ax : axes) {
+        std::vector<SignalParams> next;
+        next.reserve(grid.size() * ax.values.size());
+        for (const SignalParams& p : grid)
+            for (double v : ax.values) {
+                SignalParams q = p;
+                if (ax.name == "s1_buy") q.s1_buy = v;
+                else if (ax.name == "s1_sell") q.s1_sell = v;
+                else if (ax.name == "s2_lo") q.s2_lo = v;
+                else if (ax.name == "s2_hi") q.s2_hi = v;
+                else q.s4_k = v;
+                next.push_back(q);
+            }
+        grid.swap(next);
+    }
+    const SignalParams base{};
+    grid.erase(std::remove(grid.begin(), grid.end(), base), grid.end());
+    grid.insert(grid.begin(), base);
+    return grid;
+}
+
+struct SweepResult {
+    SignalParams params;
+    uint64_t orders = 0, buys = 0;
+    array<uint64_t, 4> signals{};   // orders attributed to S1..S4
+    double pnl = 0.0;               // unit orders marked to each instrument's last price
+};
+
+// Fixed set of task ids split over per-worker deques. A worker takes its own
+// tasks from the front and, once empty, steals from the back of the others.
+// Tasks here are whole feed passes, so a mutex per deque costs nothing.
+class WorkStealingQueues {
+public:
+    WorkStealingQueues(unsigned workers, size_t tasks) {
+        for (unsigned w = 0; w < workers; ++w) qs.push_back(std::make_unique<Deque>());
+        for (size_t t = 0; t < tasks; ++t) qs[t * workers / tasks]->q.push_back(t);
+    }
+
+    bool pop(unsigned w, size_t& task) {
+        {
+            Deque& d = *qs[w];
+            std::lock_guard<std::mutex> lk(d.m);
+            if (!d.q.empty()) { task = d.q.front(); d.q.pop_front(); return true; }
+        }
+        for (size_t i = 1; i < qs.size(); ++i) {
+            Deque& d = *qs[(w + i) % qs.size()];
+            std::lock_guard<std::mutex> lk(d.m);
+            if (!d.q.empty()) {
+                task = d.q.back();
+                d.q.pop_back();
+                n_steals.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t steals() const { return n_steals.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Deque {
+        std::mutex m;
+        std::deque<size_t> q;
+    };
+    std::vector<std::unique_ptr<Deque>> qs;
+    std::atomic<size_t> n_steals{0};
+};
+
+class ParamSweep {
+public:
+    static constexpr size_t MAX_BLOCK = 1024;
+    using History = DefaultSignals::History;
+
+    // block = configurations per feed pass (0 picks one from the grid size).
+    ParamSweep(std::vector<SignalParams> grid, int n_instruments, unsigned n_threads, size_t block = 0)
+        : n_inst(n_instruments), threads(std::max(1u, n_threads)) {
+        results.resize(grid.size());
+        for (size_t i = 0; i < grid.size(); ++i) results[i].params = grid[i];
+        if (!block) block = (grid.size() + 4 * threads - 1) / (4 * threads);   // ~4 tasks per worker
+        block_size = std::clamp<size_t>((block + 7) & ~size_t(7), 8, MAX_BLOCK);
+    }
+
+    template<class Feed>
+    void run(const Feed& feed) {
+        auto t0 = Clock::now();
+        ticks = feed.size();
+        // Mark-to-market needs each instrument's final price up front.
+        last_px.assign(n_inst, 0.0);
+        for (size_t i = 0; i < ticks; ++i) {
+            const MarketData md = feed[i];
+            last_px[md.instrument_id] = md.price;
+        }
+        const size_t n_blocks = (results.size() + block_size - 1) / block_size;
+        WorkStealingQueues queues(threads, n_blocks);
+        auto worker = [&](unsigned w) {
+            if (threads > 1) pinThreadToCore(w);
+            std::vector<History> hist;
+            size_t b;
+            while (queues.pop(w, b)) {
+                hist.assign(n_inst, History{});
+                const size_t first = b * block_size;
+                runBlock(feed, first, std::min(block_size, results.size() - first), hist);
+            }
+        };
+        if (threads == 1) worker(0);
+        else {
+            std::vector<std::thread> pool;
+            for (unsigned w = 0; w < threads; ++w) pool.emplace_back(worker, w);
+            for (auto& t : pool) t.join();
+        }
+        passes = n_blocks;
+        steals = queues.steals();
+        elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    }
+
+    const std::vector<SweepResult>& all() const { return results; }
+    const SweepResult& baseline() const { return results.front(); }
+
+    void report(std::ostream& os, size_t top = 10) const {
+        const double cfg_ticks = double(results.size()) * double(ticks);
+        os << "\n--- Parameter Sweep ---\n";
+        os << "Configurations: " << results.size() << " over " << ticks << " ticks, "
+           << threads << " thread(s), " << block_size << " configs per pass, "
+           << passes << " passes, " << steals << " steals\n";
+        os << "Sweep Time (ms): " << std::fixed << std::setprecision(1) << elapsed_ms
+           << "  (" << std::setprecision(1) << (elapsed_ms > 0 ? cfg_ticks / (elapsed_ms * 1e3) : 0.0)
+           << " M config-ticks/s, " << std::setprecision(2)
+           << (cfg_ticks > 0 ? elapsed_ms * 1e6 / cfg_ticks : 0.0) << " ns per config-tick)\n";
+        std::vector<size_t> order(results.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        top = std::min(top, order.size());
+        std::partial_sort(order.begin(), order.begin() + top, order.end(),
+                          [&](size_t a, size_t b) {
+                              return results[a].pnl > results[b].pnl || (results[a].pnl == results[b].pnl && a < b);
+                          });
+        os << "Top " << top << " by PnL:\n";
+        printHeader(os);
+        for (size_t i = 0; i < top; ++i) printRow(os, results[order[i]]);
+        os << "Baseline:\n";
+        printHeader(os);
+        printRow(os, baseline());
+        os.unsetf(std::ios::floatfield);
+        os << std::setprecision(6);
+    }
+
+    bool writeCSV(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "s1_buy,s1_sell,s2_lo,s2_hi,s4_k,orders,buys,sells,s1,s2,s3,s4,pnl\n";
+        out << std::setprecision(10);
+        for (const SweepResult& r : results) {
+            const SignalParams& p = r.params;
+            out << p.s1_buy << ',' << p.s1_sell << ',' << p.s2_lo << ',' << p.s2_hi << ',' << p.s4_k << ','
+                << r.orders << ',' << r.buys << ',' << (r.orders - r.buys);
+            for (uint64_t s : r.signals) out << ',' << s;
+            out << ',' << std::fixed << std::setprecision(5) << r.pnl << std::defaultfloat << std::setprecision(10) << '\n';
+        }
+        return bool(out);
+    }
+
+private:
+    int n_inst;
+    unsigned threads;
+    size_t block_size = 8;
+    std::vector<SweepResult> results;
+    std::vector<double> last_px;
+    size_t ticks = 0, passes = 0, steals = 0;
+    double elapsed_ms = 0.0;
+
+    // One feed pass for results[first, first+count). Mirrors the scalar
+    // strategies op for op, so the baseline row equals a TradeEngine run.
+    template<class Feed>
+    void runBlock(const Feed& feed, size_t first, size_t count, std::vector<History>& hist) {
+        alignas(64) double b1[MAX_BLOCK], s1[MAX_BLOCK], lo[MAX_BLOCK], hi[MAX_BLOCK], k[MAX_BLOCK], pnl[MAX_BLOCK];
+        alignas(64) uint64_t orders[MAX_BLOCK], buys[MAX_BLOCK], n1[MAX_BLOCK], n2[MAX_BLOCK], n4[MAX_BLOCK];
+        const size_t B = count;
+        for (size_t c = 0; c < B; ++c) {
+            const SignalParams& p = results[first + c].params;
+            b1[c] = p.s1_buy; s1[c] = p.s1_sell; lo[c] = p.s2_lo; hi[c] = p.s2_hi; k[c] = p.s4_k;
+            pnl[c] = 0.0;
+            orders[c] = buys[c] = n1[c] = n2[c] = n4[c] = 0;
+        }
+        uint64_t n3 = 0;
+
+        for (size_t i = 0; i < ticks; ++i) {
+            const MarketData md = feed[i];
+            const int id = md.instrument_id;
+            const double px = md.price;
+            History& h = hist[id];
+            h.add(px);
+
+            // Configuration-independent part of S2/S3/S4.
+            const double avg = h.avg();
+            const uint64_t ok2 = (h.size >= 5) & (avg != 0.0);
+            double a = 0, b = 0, c3 = 0;
+            const bool have3 = h.last3(a, b, c3);
+            const double d1 = b - a, d2 = c3 - b;
+            const int v3b = have3 & (d1 > 0) & (d2 > 0), v3s = have3 & (d1 < 0) & (d2 < 0);
+            n3 += uint64_t(v3b | v3s);
+#if ENABLE_VOL_SIGNAL
+            const double sd = h.stddev();
+            double prev = px;
+            h.last(prev);
+            const double chg = px - prev;
+            const uint64_t ok4 = (h.size >= 12) & (sd > 1e-9);
+#else
+            const double sd = 0.0, chg = 0.0;
+            const uint64_t ok4 = 0;
+#endif
+            const uint64_t odd = uint64_t(id & 1);
+            const double gain_buy = last_px[id] - (px + 0.01), gain_sell = (px - 0.01) - last_px[id];
+
+            for (size_t c = 0; c < B; ++c) {
+                const uint64_t bv1 = px < b1[c], sv1 = !bv1 & (px > s1[c]);
+                const uint64_t bv2 = ok2 & (px < avg * lo[c]), sv2 = ok2 & !bv2 & (px > avg * hi[c]);
+                const uint64_t bv4 = ok4 & (chg > k[c] * sd), sv4 = ok4 & !bv4 & (chg < -k[c] * sd);
+                const uint64_t bv = bv1 + bv2 + uint64_t(v3b) + bv4, sv = sv1 + sv2 + uint64_t(v3s) + sv4;
+                const uint64_t fire = (bv | sv) != 0;
+                const uint64_t is_buy = (bv > sv) | ((bv == sv) & odd);
+                orders[c] += fire;
+                buys[c] += fire & is_buy;
+                n1[c] += bv1 | sv1;
+                n2[c] += bv2 | sv2;
+                n4[c] += bv4 | sv4;
+                pnl[c] += fire ? (is_buy ? gain_buy : gain_sell) : 0.0;
+            }
+        }
+
+        for (size_t c = 0; c < B; ++c) {
+            SweepResult& r = results[first + c];
+            r.orders = orders[c];
+            r.buys = buys[c];
+            r.signals = {n1[c], n2[c], n3, n4[c]};
+            r.pnl = pnl[c];
+        }
+    }
+
+    static void printHeader(std::ostream& os) {
+        os << "  s1_buy  s1_sell  s2_lo  s2_hi  s4_k    orders      buys      S1      S2      S3      S4          pnl\n";
+    }
+    static void printRow(std::ostream& os, const SweepResult& r) {
+        const SignalParams& p = r.params;
+        os << std::fixed << std::setprecision(2)
+           << std::setw(8) << p.s1_buy << std::setw(9) << p.s1_sell << std::setprecision(3)
+           << std::setw(7) << p.s2_lo << std::setw(7) << p.s2_hi << std::setprecision(2) << std::setw(6) << p.s4_k
+           << std::setw(10) << r.orders << std::setw(10) << r.buys;
+        for (uint64_t s : r.signals) os << std::setw(8) << s;
+        os << std::setw(13) << r.pnl << "\n";
+    }
+};
+
+// --------------------------- Main ---------------------------
+// hft_bench.cpp includes this file with HFT_SIM_NO_MAIN defined.
+#ifndef HFT_SIM_NO_MAIN
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+#if ENABLE_TSC_PROFILE
+    TscClock::calibrate();
+#endif
+
+    int num_ticks = 100000;
+    int num_instruments = 10;
+    int threads = 1;
+    bool verify = false;
+    bool stream = false;
+    size_t ring_capacity = 1024;
+    bool columnar = false;
+    bool fixed_point = false;
+    string record_path, replay_path;
+    bool simd = false;
+    int latency_bits = 8;
+    bool rolling = false;
+    string journal_path;
+    bool journal_binary = false;
+    size_t snapshot_every = 0;
+    bool lob = false;
+    LobConfig lob_cfg;
+    bool sweep = false;
+    std::vector<SweepAxis> sweep_axes;
+    size_t sweep_block = 0;
+    string sweep_out = "sweep.csv";
+    string metrics_name;
+    bool counter_gen = false;
+    CounterFeedConfig gen_cfg;
+    gen_cfg.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--ticks" && i+1 < argc) num_ticks = stoi(argv[++i]);
+        else if (arg == "--instruments" && i+1 < argc) num_instruments = stoi(argv[++i]);
+        else if (arg == "--threads" && i+1 < argc) {
+            threads = stoi(argv[++i]);
+            if (threads < 1) { cerr << "Error: --threads must be at least 1\n"; return 1; }
+        }
+        else if (arg == "--verify") verify = true;
+        else if (arg == "--stream") stream = true;
+        else if (arg == "--ring" && i+1 < argc) ring_capacity = stoul(argv[++i]);
+        else if (arg == "--columnar") columnar = true;
+        else if (arg == "--fixed-point") fixed_point = columnar = true;
+        else if (arg == "--record" && i+1 < argc) record_path = argv[++i];
+        else if (arg == "--replay" && i+1 < argc) replay_path = argv[++i];
+        else if (arg == "--simd") simd = true;
+        else if (arg == "--rolling") rolling = true;
+        else if (arg == "--latency-bits" && i+1 < argc) latency_bits = stoi(argv[++i]);
+        else if (arg == "--snapshot-every" && i+1 < argc) snapshot_every = stoul(argv[++i]);
+        else if (arg == "--journal" && i+1 < argc) journal_path = argv[++i];
+        else if (arg == "--journal-binary" && i+1 < argc) { journal_path = argv[++i]; journal_binary = true; }
+        else if (arg == "--lob") lob = true;
+        else if (arg == "--lob-depth" && i+1 < argc) { lob_cfg.depth = stoi(argv[++i]); lob = true; }
+        else if (arg == "--lob-qty" && i+1 < argc) { lob_cfg.order_qty = stoll(argv[++i]); lob = true; }
+        else if (arg == "--lob-reach" && i+1 < argc) { lob_cfg.max_reach = stoi(argv[++i]); lob = true; }
+        else if (arg == "--lob-seed" && i+1 < argc) { lob_cfg.seed = stoull(argv[++i]); lob = true; }
+        else if (arg == "--sweep") sweep = true;
+        else if (arg == "--grid" && i+1 < argc) {
+            SweepAxis axis;
+            if (!parseSweepAxis(argv[++i], axis)) {
+                cerr << "Error: bad --grid '" << argv[i] << "' (want s1_buy|s1_sell|s2_lo|s2_hi|s4_k=lo:hi:step or =v1,v2,...)\n";
+                return 1;
+            }
+            sweep_axes.push_back(axis);
+            sweep = true;
+        }
+        else if (arg == "--sweep-block" && i+1 < argc) sweep_block = stoul(argv[++i]);
+        else if (arg == "--sweep-out" && i+1 < argc) sweep_out = argv[++i];
+        else if (arg == "--metrics" && i+1 < argc) metrics_name = argv[++i];
+        else if (arg == "--gen" && i+1 < argc) {
+            const string gen = argv[++i];
+            if (gen != "mt" && gen != "counter") { cerr << "Error: --gen must be mt or counter, got '" << gen << "'\n"; return 1; }
+            counter_gen = gen == "counter";
+        }
+        else if (arg == "--seed" && i+1 < argc) gen_cfg.seed = stoull(argv[++i]);
+        else if (arg == "--corr" && i+1 < argc) { gen_cfg.rho = stod(argv[++i]); counter_gen = true; }
+        else if (arg == "--corr-block" && i+1 < argc) gen_cfg.corr_block = stoi(argv[++i]);
+        else if (arg == "--gen-threads" && i+1 < argc) gen_cfg.threads = unsigned(std::max(1, stoi(argv[++i])));
+    }
+    auto badCorrelation = [&] {
+        const int block = std::clamp(gen_cfg.corr_block, 1, std::max(num_instruments, 1));
+        cerr << "Error: --corr " << gen_cfg.rho << " over blocks of " << block
+             << " instruments is not a valid correlation (needs " << (block > 1 ? -1.0 / (block - 1) : -1.0)
+             << " < rho < 1)\n";
+        return 1;
+    };
+
+    if (!record_path.empty()) {
+        // Dump a generated session to a binary tick file, tick by tick.
+        vector<MarketData> unused;
+        MarketDataFeed generator(unused, num_instruments);
+        if (counter_gen && !generator.useCounterRng(gen_cfg)) return badCorrelation();
+        TickFileWriter writer;
+        if (!writer.open(record_path, num_instruments)) return 1;
+        auto t0 = Clock::now();
+        generator.generate(num_ticks, [&](const MarketData& md) { writer.write(md); });
+        if (!writer.close()) { cerr << "Error: failed writing " << record_path << "\n"; return 1; }
+        cout << "Recorded " << num_ticks << " ticks to " << record_path << " in "
+             << std::chrono::duration_cast<ms>(Clock::now() - t0).count() << " ms\n";
+        return 0;
+    }
+
+    MappedTickFile replay;
+    if (!replay_path.empty()) {
+        if (!replay.open(replay_path)) return 1;
+        num_instruments = std::max(num_instruments, replay.numInstruments());
+        stream = false;
+    }
+    bool replaying = !replay_path.empty();
+
+    if (sweep) stream = false; // the sweep makes many passes over a stored feed
+    if (stream) {
+        size_t cap = 1;
+        while (cap < ring_capacity) cap <<= 1;
+        ring_capacity = cap;
+        threads = 1; // one producer, one consumer
+    }
+
     vector<MarketData> feed;
-    MarketDataFeed generator(feed);
+    MarketDataColumns feed_cols(fixed_point);
+    MarketDataFeed generator(feed, num_instruments);
+    if (counter_gen && !generator.useCounterRng(gen_cfg)) return badCorrelation();
+    bool columnar_feed = columnar && !stream && !replaying;
+    auto makeEngine = [&](int n_threads) {
+        TradeEngine e = replaying ? TradeEngine(replay, num_instruments, n_threads)
+                      : columnar_feed ? TradeEngine(feed_cols, num_instruments, n_threads)
+                      : TradeEngine(feed, num_instruments, n_threads);
+        if (columnar) e.setColumnarOrders(fixed_point);
+        e.setBatchedSignals(simd);
+        e.setRollingStats(rolling);
+        e.setLatencyPrecision(latency_bits);
+        e.setSnapshotInterval(snapshot_every);
+        return e;
+    };
+
+    if (sweep) {
+        if (sweep_axes.empty()) {
+            // Default grid: 5 points per constant around the hard-coded values (3125 configs).
+            for (const char* spec : {"s1_buy=95:115:5", "s1_sell=185:205:5", "s2_lo=0.96:1.0:0.01",
+                                     "s2_hi=1.0:1.04:0.01", "s4_k=1:3:0.5"}) {
+                sweep_axes.emplace_back();
+                parseSweepAxis(spec, sweep_axes.back());
+            }
+        }
+        if (columnar_feed) generator.generateData(num_ticks, feed_cols);
+        else if (!replaying) generator.generateData(num_ticks);
+        ParamSweep sw(expandGrid(sweep_axes), num_instruments, unsigned(threads), sweep_block);
+        if (replaying) sw.run(replay);
+        else if (columnar_feed) sw.run(feed_cols);
+        else sw.run(feed);
+        sw.report(cout);
+        if (!sw.writeCSV(sweep_out)) { cerr << "Error: cannot write " << sweep_out << "\n"; return 1; }
+        cout << "Sweep results: " << sw.all().size() << " rows to " << sweep_out << "\n";
+        cout << "Peak RSS (KB): " << peakRssKB() << "\n";
+        if (verify) {
+            // The baseline row must match the engine with the built-in constants.
+            TradeEngine ref = makeEngine(1);
+            ref.process();
+            const SweepResult& b = sw.baseline();
+            size_t ref_buys = 0;
+            for (size_t i = 0; i < ref.orderCount(); ++i) ref_buys += ref.orderAt(i).is_buy;
+            bool same = b.orders == ref.orderCount() && b.buys == ref_buys;
+            for (size_t s = 0; s < ref.signalCounts().size(); ++s) same = same && b.signals[s] == ref.signalCounts()[s];
+            cout << "Verify baseline vs engine: " << (same ? "identical" : "MISMATCH") << "\n";
+            if (!same) return 1;
+        }
+        return 0;
+    }
 
     auto start = Clock::now();
-    generator.generateData(100000);
+    TradeEngine engine = makeEngine(threads);
+    RingStats ring_stats;
+
+    std::unique_ptr<OrderJournal> journal;
+    if (!journal_path.empty()) {
+        journal = std::make_unique<OrderJournal>(journal_path,
+            journal_binary ? OrderJournal::Format::Binary : OrderJournal::Format::CSV, int(engine.shardCount()));
+        if (!journal->ok() || !engine.attachJournal(journal.get())) return 1;
+        verify = false; // orders are not kept in memory
+    }
+
+    std::unique_ptr<MetricsSegment> metrics;
+    if (!metrics_name.empty()) {
+        if (metrics_name[0] != '/') metrics_name = "/" + metrics_name;
+        std::vector<std::string> names(DefaultSignals::names.begin(), DefaultSignals::names.end());
+        metrics = MetricsSegment::create(metrics_name, int(engine.shardCount()), num_instruments, names);
+        if (!metrics) return 1;
+        engine.attachMetrics(metrics.get());
+        metrics->setState(METRICS_RUNNING);
+    }
 
-    TradeEngine engine(feed);
-    engine.process();
+    if (stream) {
+        // Producer publishes each tick as it is generated; the consumer (this
+        // thread) runs the signals, so latency is queueing plus compute time.
+        SpscRing<MarketData> ring(ring_capacity);
+        std::atomic<bool> done{false};
+        std::thread producer([&] {
+            pinThreadToCore(0);
+            generator.generate(num_ticks, [&](const MarketData& md) {
+                if (!ring.tryPush(md)) {
+                    ring_stats.full_events++;
+                    auto t0 = Clock::now();
+                    unsigned spins = 0;
+                    do { ring_stats.full_spins++; backoff(spins); } while (!ring.tryPush(md));
+                    ring_stats.stall_ns += std::chrono::duration_cast<ns>(Clock::now() - t0).count();
+                }
+                ring_stats.published++;
+            });
+            done.store(true, std::memory_order_release);
+        });
+        pinThreadToCore(1);
+        engine.processStream(ring, done);
+        producer.join();
+    } else {
+        auto g0 = Clock::now();
+        if (columnar_feed) generator.generateData(num_ticks, feed_cols);
+        else if (!replaying) generator.generateData(num_ticks);
+        if (counter_gen && !replaying)
+            cout << "Feed Generation (ms): " << std::chrono::duration_cast<ms>(Clock::now() - g0).count()
+                 << " (counter-based, " << gen_cfg.threads << " threads)\n";
+        engine.process();
+    }
+
+    if (journal) journal->close();
+    if (metrics) metrics->setState(METRICS_DONE);
 
     auto end = Clock::now();
     auto runtime = std::chrono::duration_cast<ms>(end - start).count();
 
     engine.reportStats();
+    if (stream) {
+        cout << "\nStreaming pipeline (ring capacity " << ring_capacity << "):\n";
+        cout << "  Ticks Published     : " << ring_stats.published << "\n";
+        cout << "  Ring Full Events    : " << ring_stats.full_events << "\n";
+        cout << "  Producer Spins      : " << ring_stats.full_spins << "\n";
+        cout << "  Producer Stall (us) : " << ring_stats.stall_ns / 1000 << "\n";
+        cout << "  Consumer Idle Polls : " << engine.idlePolls() << "\n";
+    }
+    if (replaying) {
+        cout << "\nReplayed " << replay.size() << " ticks from " << replay_path << " (mmap)\n";
+    } else if (!stream) {
+        size_t feed_bytes = columnar_feed ? feed_cols.bytes() : feed.capacity() * sizeof(MarketData);
+        cout << "\nFeed Storage (KB): " << feed_bytes / 1024
+             << (columnar_feed ? (fixed_point ? " (columnar, fixed-point)" : " (columnar)") : " (row)") << "\n";
+    }
+    if (journal) {
+        cout << "Order Journal: " << journal->ordersWritten() << " orders, "
+             << journal->bytesWritten() / 1024 << " KB to " << journal_path
+             << (journal_binary ? " (binary)" : " (csv)") << ", ring-full events "
+             << journal->fullEvents() << "\n";
+    }
+    cout << "Peak RSS (KB): " << peakRssKB() << "\n";
     engine.exportCSV("orders.csv"); // bonus
 
     cout << "Total Runtime (ms): " << runtime << "\n";
+
+    if (lob) {
+        if (stream || journal) {
+            cerr << "Error: --lob needs the feed and the orders in memory (no --stream / --journal)\n";
+        } else {
+#if !ENABLE_TSC_PROFILE
+            TscClock::calibrate();
+#endif
+            MatchingSim sim(num_instruments, lob_cfg, latency_bits);
+            if (replaying) sim.run(replay, engine);
+            else if (columnar_feed) sim.run(feed_cols, engine);
+            else sim.run(feed, engine);
+            sim.report();
+        }
+    }
+
+    if (verify && !stream) {
+        // Re-run single-threaded, scalar signals, and compare the order stream field by field.
+        TradeEngine ref = makeEngine(1);
+        ref.setBatchedSignals(false);
+        ref.process();
+        bool same = engine.orderCount() == ref.orderCount();
+        for (size_t i = 0; same && i < ref.orderCount(); ++i) {
+            Order a = engine.orderAt(i), b = ref.orderAt(i);
+            same = a.instrument_id == b.instrument_id && a.price == b.price
+                && a.is_buy == b.is_buy && a.signal_mask == b.signal_mask;
+        }
+        cout << "Verify vs single-threaded: " << (same ? "identical" : "MISMATCH") << "\n";
+        if (!same) return 1;
+        if (counter_gen && !replaying && !(columnar_feed && fixed_point)) {
+            // The counter-based feed must not depend on how many threads drew it,
+            // nor on whether it was filled at once (rows) or block by block (columns).
+            vector<MarketData> again;
+            MarketDataFeed serial(again, num_instruments);
+            CounterFeedConfig one = gen_cfg;
+            one.threads = 1;
+            serial.useCounterRng(one);
+            serial.generateData(num_ticks);
+            auto sameAs = [&](const auto& f) {
+                bool same_ticks = again.size() == f.size();
+                for (size_t i = 0; same_ticks && i < f.size(); ++i) {
+                    const MarketData md = f[i];
+                    same_ticks = again[i].instrument_id == md.instrument_id && again[i].price == md.price;
+                }
+                return same_ticks;
+            };
+            const bool feed_same = columnar_feed ? sameAs(feed_cols) : sameAs(feed);
+            cout << "Verify feed vs 1-thread generation: " << (feed_same ? "identical" : "MISMATCH") << "\n";
+            if (!feed_same) return 1;
+        }
+    }
     return 0;
 }
+#endif // HFT_SIM_NO_MAIN